@@ -0,0 +1,163 @@
+//
+// access.h: Access patterns of buffer elements for working set
+//           measurements
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "memory.h"
+
+///////////////////////////////////////////////////////////
+//                 Access patterns
+///////////////////////////////////////////////////////////
+
+// Order of accesses to elements of the buffer:
+//   seq    - consecutive elements
+//   stride - elements access_stride bytes apart (wraps around)
+//   rand   - pointer chase: each element stores the index of the next
+//            one in a random cycle (defeats hardware prefetchers)
+//   zipf   - Zipf-distributed element ranks, hot elements are scattered
+//            over the buffer (skewed hash table lookups)
+enum class access_type { seq, stride, rand, zipf };
+
+// Distance between elements in strided pattern (bytes), larger than
+// the pair of lines of adjacent-line prefetcher
+const size_t access_stride = 4 * cache_line_size;
+
+// Exponent of Zipf distribution
+const double zipf_skew = 0.99;
+
+// Multiplier scattering Zipf ranks over the buffer (prime)
+const uint64_t zipf_scatter = 2654435761u;
+
+// access_type_by_name: Parse access pattern name
+inline bool access_type_by_name(const std::string &name, access_type &type)
+{
+    if (name == "seq")
+        type = access_type::seq;
+    else if (name == "stride")
+        type = access_type::stride;
+    else if (name == "rand")
+        type = access_type::rand;
+    else if (name == "zipf")
+        type = access_type::zipf;
+    else
+        return false;
+
+    return true;
+}
+
+// access_type_name: Name of access pattern
+inline std::string access_type_name(access_type type)
+{
+    switch (type) {
+    case access_type::seq:    return "seq";
+    case access_type::stride: return "stride";
+    case access_type::rand:   return "rand";
+    case access_type::zipf:   return "zipf";
+    }
+
+    return "";
+}
+
+// rand_cycle: Random cyclic permutation of count elements
+//             (Sattolo's algorithm), next[i] is the successor of i
+inline std::vector<uint32_t> rand_cycle(size_t count, std::mt19937_64 &rng)
+{
+    std::vector<uint32_t> next(count);
+
+    for (size_t i = 0; i < count; i++)
+        next[i] = i;
+
+    for (size_t i = count - 1; i > 0; i--) {
+        const auto j = std::uniform_int_distribution<size_t>(0, i - 1)(rng);
+        std::swap(next[i], next[j]);
+    }
+
+    return next;
+}
+
+// rand_chain: Indexes of next elements of pointer chase over count 
+//             elements (seeded for reproducibility)
+inline std::vector<uint32_t> rand_chain(size_t count, int seed)
+{
+    std::mt19937_64 rng(seed);
+
+    return rand_cycle(count, rng);
+}
+
+// zipf_rank: Zipf-distributed rank in [0, count) by inversion of
+//            continuous approximation of the distribution function
+inline size_t zipf_rank(size_t count, double u)
+{
+    double x;
+
+    if (std::abs(zipf_skew - 1) < 1e-9) {
+        x = std::pow(double(count), u);
+    } else {
+        const auto e = 1 - zipf_skew;
+        x = std::pow((std::pow(double(count), e) - 1) * u + 1, 1 / e);
+    }
+
+    // x is in [1, count]
+    return std::min(size_t(x), count) - 1;
+}
+
+// access_seq: Indexes of n accesses to buffer of count elements
+//             of elem_size bytes (generated before measurements,
+//             seeded for reproducibility). For rand only the first 
+//             element of the chase is given, next indexes are loaded 
+//             from the buffer (rand_chain())
+inline std::vector<uint32_t> access_seq(access_type type, size_t count,
+                                        size_t elem_size, int n, int seed)
+{
+    std::vector<uint32_t> seq(n);
+    std::mt19937_64 rng(seed);
+
+    if (count == 0)
+        return {};
+
+    switch (type) {
+    case access_type::seq:
+        for (auto i = 0; i < n; i++)
+            seq[i] = i % count;
+        break;
+    case access_type::stride: {
+        const auto step = std::max(access_stride / elem_size, size_t(1));
+        size_t first = 0, ind = 0;
+
+        for (auto i = 0; i < n; i++) {
+            seq[i] = ind;
+            ind += step;
+
+            // Next pass starts from the element after the first one
+            if (ind >= count) {
+                first = (first + 1) % step;
+                ind = first % count;
+            }
+        }
+        break;
+    }
+    case access_type::rand:
+        seq.assign(1, seed % count);
+        break;
+    case access_type::zipf: {
+        std::uniform_real_distribution<> unif(0, 1);
+
+        for (auto i = 0; i < n; i++)
+            seq[i] = zipf_rank(count, unif(rng)) * zipf_scatter % count;
+        break;
+    }
+    }
+
+    return seq;
+}
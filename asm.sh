@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+# asm.sh: Print instructions of timed regions (between timer_start() and
+#         timer_stop()) of measurement kernels from generated assembly.
+#         The region ends at the end mark or at the jump to the code 
+#         shared with the other timer branch
+#
+# Usage: ./asm.sh FILE.s [PATTERN]
+#        PATTERN selects kernels by name, e.g. 'timed_op<FAA_op<unsigned int'
+#
+
+c++filt <$1 | awk -v pattern="$2" '
+    function flush() {
+        if (timed && (body != ""))
+            printf "%s:\n%s\n", fname, body
+        timed = 0
+    }
+    /^[^ \t.].*:$/ { 
+        timed = 0
+        fname = substr($0, 1, length($0) - 1)
+        next 
+    }
+    /# timed region begin/ { 
+        timed = (index(fname, pattern) > 0)
+        body = ""
+        next 
+    }
+    /# timed region end/ { flush(); next }
+    timed && /^\t(jmp|ret)/ { flush(); next }
+    timed && /^\t[a-z]/ { body = body $0 "\n" }
+'
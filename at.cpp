@@ -17,38 +17,37 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <array>
+#include <utility>
+#include <functional>
+#include <tuple>
+#include <cstdint>
+#include <numeric>
+#include <ctime>
 
 #include <unistd.h>
+#include <sys/utsname.h>
 
 #include "utils.h"
-
-//#define CONT_MEAS_ENABLE
-//#define DELAY_MEAS_ENABLE
-//#define MESI_MEAS_ENABLE
-//#define ARRAY_MEAS_ENABLE
-#define BARRIER_MEAS_ENABLE
-
-const auto nruns      = 1'000;
-
-const auto nthr_min   = 4;
-const auto nthr_max   = 12;
-const auto nthr_step  = 4;
-
-const auto delay_min  = 0;
-// const auto delay_max  = 10000000;
-// const auto delay_step = 500000;
-const auto delay_max  = 3000;
-const auto delay_step = 1000;
-
-const auto stride_min = 0;
-const auto stride_max = 100;
-const auto stride_step = 20;
-
-// const std::vector<int> delay_nthr{2, 4, 8, 16, 32, 64};
-const std::array<int, 3> delay_nthr{16, 32, 64};
-
-const auto padding_size = 100'000;
-
+#include "timer.h"
+#include "config.h"
+#include "hist.h"
+#include "topology.h"
+#include "atomic128.h"
+#include "locks.h"
+#include "delay.h"
+#include "memory.h"
+#include "sink.h"
+
+// Number of back-to-back operations per timed region in batch mode
+// (batch sizes to run are selected from these in runtime)
+using batch_sizes = std::integer_sequence<int, 1, 8, 64, 512>;
+
+// Number of operations between checks of the stop flag in throughput 
+// measurements
+const auto tput_chunk = 64;
+
+// Number of elements of buffers in stride measurements of array suite
 const auto atbuf_size = 10000;
 
 const int atvar_def = 0;
@@ -58,49 +57,131 @@ const int des_def2 = 2;
 const int loaded_def = 0;
 const int val_def = 0;
 
-// Atomic variables with padding
-struct atvar_pad {
-    std::atomic<int> atvar = 0;
-    int padding[padding_size];
-};
-
-// Common variable with padding
-struct var_pad {
-    int var = 0;
-    int padding[padding_size];
+// Make all variables used within threads thread-local
+// (allocated in init_width_data() for the maximal number of threads
+// and the operand type T of current width, variables of consecutive 
+// threads are cfg.spacing apart)
+template <typename T> spaced_array<atomic_type<T>> atarr;
+
+template <typename T> spaced_array<T> exptd;
+template <typename T> spaced_array<T> des;
+template <typename T> spaced_array<T> des2;
+template <typename T> spaced_array<T> loaded;
+template <typename T> spaced_array<T> val;
+
+// Buffers of threads (page-aligned, elements are packed)
+template <typename T> std::vector<spaced_array<atomic_type<T>>> atbuf;
+
+// Element of pointer-chase buffer: atomic variable and index of the 
+// next element (operations on the variable do not break the chain)
+template <typename T>
+struct chase_elem {
+    atomic_type<T> var;
+    uint32_t next = 0;
 };
 
-// Make all variables used within threads thread-local
-constexpr int nthr_glob = 
-    std::max(*std::max_element(delay_nthr.begin(), 
-                               delay_nthr.end()), nthr_max);
+// Pointer-chase buffers of threads (rand pattern of working set 
+// measurements, elements are packed)
+template <typename T> std::vector<spaced_array<chase_elem<T>>> atchase;
 
-//atvar_pad *atarr = nullptr;
-std::array<atvar_pad, nthr_glob> atarr;
+// Indexes of buffer elements accessed by threads in working set 
+// measurements (generated by the main thread before threads start,
+// for rand - the first element of the chase)
+std::vector<std::vector<uint32_t>> wset_seq;
 
-std::array<var_pad, nthr_glob> exptd;
-std::array<var_pad, nthr_glob> des;
-std::array<var_pad, nthr_glob> des2;
-std::array<var_pad, nthr_glob> loaded;
-std::array<var_pad, nthr_glob> val;
+// Event counts of a measurement (summed over threads and repetitions),
+// the meaning depends on test type
+const auto max_stats = 4;
 
-std::array<std::array<std::atomic<int>, atbuf_size>, nthr_max> atbuf;
+using result_stats = std::array<double, max_stats>;
 
-// Sum of avg times and mutex to protect it
+// Sum of avg times
 struct avgtime_val {
     std::string test_type;
     std::string atop_name;
     std::string MESI_state;
+    int width;
+    std::memory_order order = std::memory_order_seq_cst;
     int nthr;
     int delay;
     int stride;
+    int batch;
+
+    // Access pattern and buffer size of working set measurements
+    std::string pattern;
+    int size_kb;
+
+    int count;
+    double time;
+    double rate;
+    histogram hist;
+    result_stats stats;
+
+    // Node of test variables (-1 if unknown or different for threads) 
+    // and number of measurements on memory of remote node
+    int mem_node;
+    int remote;
+
+    // Counts of events per operation (summed over threads)
+    counter_values counters;
+};
+
+// Names of test types, operations and MESI states. Registered by the 
+// main thread before measurement threads start, so threads only read it
+std::vector<std::string> names;
+
+// Result key: ids of test type, operation and MESI state in names
+// and the experiment parameters
+struct result_key {
+    uint16_t test;
+    uint16_t atop;
+    uint16_t state;
+    uint16_t width;
+    uint16_t order;
+    uint16_t nthr;
+    int32_t delay;
+    int32_t stride;
+    int32_t batch;
+    uint16_t pattern;
+    int32_t size_kb;
+
+    bool operator<(const result_key &k) const
+    {
+        return std::tie(test, atop, state, width, order, nthr, delay, 
+                        stride, batch, pattern, size_kb) <
+               std::tie(k.test, k.atop, k.state, k.width, k.order, k.nthr, 
+                        k.delay, k.stride, k.batch, k.pattern, k.size_kb);
+    }
+};
+
+std::map<result_key, avgtime_val> avgtime_sum;
+
+// Result of one measurement of a thread
+struct alignas(64) result_slot {
+    result_key key;
     double time;
+    double rate;
+    histogram hist;
+    result_stats stats;
+    int mem_node;
+    bool remote;
+    counter_values counters;
+};
+
+// Maximal number of measurements of a thread in one launch
+const auto max_result_slots = 32;
+
+// Per-thread results: filled by the owner thread without locks,
+// reduced by the main thread after join (reduce_results())
+struct alignas(64) thread_results {
+    std::array<result_slot, max_result_slots> slots;
+    int nslots = 0;
 };
 
-std::map<std::string, avgtime_val> avgtime_sum;
+std::vector<thread_results> results;
 
-// Mutex to protect output
-std::mutex mut;
+// Index of the results of current thread
+thread_local int results_ithr = 0;
 
 // Flag to synchronize threads
 std::atomic<bool> prepflag(false);
@@ -109,1023 +190,3596 @@ std::atomic<bool> prepflag(false);
 std::atomic<bool> meas_ready(false);
 std::atomic<bool> prep_ready(false);
 
-using time_units = std::chrono::nanoseconds;
-
 barrier barr;
 
-// Affinity to bind measurement and prep thread
-const auto meas_cpu = 0;
-const auto prep_cpu = 2;
+// CPUs of measurement threads in order of thread ids (placement policy)
+std::vector<int> thread_cpus;
 
-auto get_time = std::chrono::steady_clock::now;
+// CPUs of measurement and preparation threads in MESI measurements
+int meas_cpu = 0;
+int prep_cpu = 0;
 
-///////////////////////////////////////////////////////////
-//                 Atomic operations (scalar)
-///////////////////////////////////////////////////////////
+// CPUs of reader thread (O and F states) and of preparation threads 
+// on the other socket and in other L3 (-1 if there is no such CPU)
+int reader_cpu = -1;
+int remote_socket_cpu = -1;
+int remote_l3_cpu = -1;
 
-// CAS: successful CAS
-inline void CAS(int ithr)
-{
-    atarr[ithr].atvar.compare_exchange_weak(exptd[ithr].var, des[ithr].var);
-}
+// Run description (placement) saved to data files
+std::string run_info;
 
-// unCAS: unsuccessful CAS
-inline void unCAS(int ithr)
-{
-    atarr[ithr].atvar.compare_exchange_weak(des[ithr].var, des2[ithr].var);
-}
+// Id of the run in result records (start time and pid)
+std::string run_id;
+
+// Suite of current results
+std::string current_suite;
+
+// Build type and flags (set by Makefile)
+#ifndef BUILD_TYPE
+#define BUILD_TYPE "unknown"
+#endif
 
-inline void SWAP(int ithr)
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS ""
+#endif
+
+// build_info: Description of the build saved to data files
+std::string build_info()
 {
-    loaded[ithr].var = atarr[ithr].atvar.exchange(des[ithr].var);
+    std::ostringstream info;
+
+    info << "build " << BUILD_TYPE << " compiler g++ " << __VERSION__ 
+         << " flags " << BUILD_FLAGS;
+
+#ifndef __OPTIMIZE__
+    info << " (unoptimized)";
+#endif
+
+    return info.str();
 }
 
-inline void FAA(int ithr)
+// make_run_id: Id of the run from start time and pid
+std::string make_run_id()
 {
-    atarr[ithr].atvar.fetch_add(1);
+    char date[32];
+    const auto now = std::time(nullptr);
+
+    std::strftime(date, sizeof(date), "%Y%m%d-%H%M%S", 
+                  std::localtime(&now));
+
+    return std::string(date) + "-" + std::to_string(getpid());
 }
 
-inline void load(int ithr)
+// cpu_model: CPU model name from /proc/cpuinfo
+std::string cpu_model()
 {
-    loaded[ithr].var = atarr[ithr].atvar.load();
+    std::ifstream file("/proc/cpuinfo");
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.compare(0, 10, "model name") == 0)
+            return trim(line.substr(line.find(':') + 1));
+    }
+
+    return "unknown";
 }
 
-inline void store(int ithr)
+// run_metadata: Environment and configuration of the run 
+//               (the first record of results)
+record run_metadata(int argc, char *argv[])
 {
-    atarr[ithr].atvar.store(des[ithr].var);
+    record meta;
+
+    char date[32];
+    const auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", 
+                  std::localtime(&now));
+
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+
+    utsname uts{};
+    uname(&uts);
+
+    std::string cmdline;
+    for (auto i = 0; i < argc; i++)
+        cmdline += (i == 0 ? "" : " ") + std::string(argv[i]);
+
+    std::string events;
+    for (const auto &event: counter_events)
+        events += (events.empty() ? "" : ",") + event.name;
+
+    meta.add("record", "run");
+    meta.add("run", run_id);
+    meta.add("date", date);
+    meta.add("host", host);
+    meta.add("cpu", cpu_model());
+    meta.add("cpus", topo.cpus.size());
+    meta.add("kernel", std::string(uts.sysname) + " " + uts.release + " " 
+                       + uts.version);
+    meta.add("arch", uts.machine);
+    meta.add("compiler", "g++ " __VERSION__);
+    meta.add("build", BUILD_TYPE);
+    meta.add("flags", BUILD_FLAGS);
+    meta.add("cmdline", cmdline);
+    meta.add("placement", run_info);
+    meta.add("timer", cfg.timer == timer_type::tsc ? "tsc" : "steady");
+    meta.add("barrier", barrier_type_name(cfg.barr_type));
+    meta.add("nruns", cfg.nruns);
+    meta.add("reps", cfg.nreps);
+    meta.add("duration_ms", cfg.duration);
+    meta.add("counters", events);
+
+    return meta;
 }
 
 ///////////////////////////////////////////////////////////
-//                 Atomic operations (buffer)
+//                 Atomic operations
 ///////////////////////////////////////////////////////////
 
-// CAS: successful CAS
-inline void CAS_arr(int ithr, int ind)
-{
-    atbuf[ithr][ind].compare_exchange_weak(exptd[ithr].var, des[ithr].var);
-}
+// Operations are functors instantiated for operand type T and memory 
+// order MO (CAS failure order is derived from MO by std::atomic): 
+// op(opnd) works on operands resolved before the timed region (the
+// atomic variable of a thread or an element of its buffer). Measurement 
+// kernels are instantiated for the functor type, so only the atomic 
+// instruction is inlined into the timed region
+
+// Type list of functors
+template <typename... Ts>
+struct type_list {};
+
+// operands: Atomic variable and values of an operation (copies, so 
+//           failed CAS does not change exptd and des)
+template <typename T>
+struct operands {
+    atomic_type<T> &var;
+    T exptd;
+    T des;
+    T des2;
+};
 
-// unCAS: unsuccessful CAS
-inline void unCAS_arr(int ithr, int ind)
+// var_operands: Operands on the atomic variable of thread ithr
+template <typename T>
+inline operands<T> var_operands(int ithr)
 {
-    atbuf[ithr][ind].compare_exchange_weak(des[ithr].var, des2[ithr].var);
+    return {atarr<T>[ithr], exptd<T>[ithr], des<T>[ithr], des2<T>[ithr]};
 }
 
-inline void SWAP_arr(int ithr, int ind)
+// buf_operands: Operands on ind-th element of the buffer of thread ithr
+template <typename T>
+inline operands<T> buf_operands(int ithr, int ind)
 {
-    loaded[ithr].var = atbuf[ithr][ind].exchange(des[ithr].var);
+    return {atbuf<T>[ithr][ind], exptd<T>[ithr], des<T>[ithr], 
+            des2<T>[ithr]};
 }
 
-inline void FAA_arr(int ithr, int ind)
+// chase_operands: Operands on ind-th element of the chase buffer of 
+//                 thread ithr
+template <typename T>
+inline operands<T> chase_operands(int ithr, int ind)
 {
-    atbuf[ithr][ind].fetch_add(1);
+    return {atchase<T>[ithr][ind].var, exptd<T>[ithr], des<T>[ithr], 
+            des2<T>[ithr]};
 }
 
-inline void load_arr(int ithr, int ind)
-{
-    loaded[ithr].var = atbuf[ithr][ind].load();
-}
+// Results of operations are used, so the compiler keeps them (e.g. 
+// fetch_add is not turned into lock add)
 
-inline void store_arr(int ithr, int ind)
-{
-    atbuf[ithr][ind].store(des[ithr].var);
-}
+// CAS_op: successful CAS
+template <typename T, std::memory_order MO>
+struct CAS_op {
+    using type = T;
+    static constexpr auto name = "CAS";
 
-///////////////////////////////////////////////////////////
-//                 Atomic operations (barrier)
-///////////////////////////////////////////////////////////
+    void operator()(const operands<T> &opnd) const
+    {
+        T expected = opnd.exptd;
+        opnd.var.compare_exchange_weak(expected, opnd.des, MO);
+    }
+};
 
-// CAS: successful CAS
-inline void CAS_barr(int ithr)
-{
-    atarr[ithr].atvar.compare_exchange_weak(exptd[ithr].var, des[ithr].var,
-                                            std::memory_order_relaxed,
-                                            std::memory_order_relaxed);
-}
+// unCAS_op: unsuccessful CAS
+template <typename T, std::memory_order MO>
+struct unCAS_op {
+    using type = T;
+    static constexpr auto name = "unCAS";
 
-// unCAS: unsuccessful CAS
-inline void unCAS_barr(int ithr)
-{
-    atarr[ithr].atvar.compare_exchange_weak(des[ithr].var, des2[ithr].var,
-                                            std::memory_order_relaxed,
-                                            std::memory_order_relaxed);
-}
+    void operator()(const operands<T> &opnd) const
+    {
+        T expected = opnd.des;
+        opnd.var.compare_exchange_weak(expected, opnd.des2, MO);
+    }
+};
 
-inline void SWAP_barr(int ithr)
+template <typename T, std::memory_order MO>
+struct SWAP_op {
+    using type = T;
+    static constexpr auto name = "SWAP";
+
+    void operator()(const operands<T> &opnd) const
+    {
+        do_not_optimize(opnd.var.exchange(opnd.des, MO));
+    }
+};
+
+template <typename T, std::memory_order MO>
+struct FAA_op {
+    using type = T;
+    static constexpr auto name = "FAA";
+
+    void operator()(const operands<T> &opnd) const
+    {
+        do_not_optimize(opnd.var.fetch_add(T(1), MO));
+    }
+};
+
+template <typename T, std::memory_order MO>
+struct load_op {
+    using type = T;
+    static constexpr auto name = "load";
+
+    void operator()(const operands<T> &opnd) const
+    {
+        do_not_optimize(opnd.var.load(MO));
+    }
+};
+
+template <typename T, std::memory_order MO>
+struct store_op {
+    using type = T;
+    static constexpr auto name = "store";
+
+    void operator()(const operands<T> &opnd) const
+    {
+        opnd.var.store(opnd.des, MO);
+    }
+};
+
+// Operations of scalar and buffer measurements (load and store are 
+// added by make_order_ops() for orders they allow)
+template <typename T, std::memory_order MO>
+using rmw_ops = type_list<CAS_op<T, MO>, unCAS_op<T, MO>, SWAP_op<T, MO>, 
+                          FAA_op<T, MO>>;
+
+// The first and the second operation of pairs in barrier suite (relaxed)
+template <typename T>
+using barr_ops1 = type_list<CAS_op<T, std::memory_order_relaxed>, 
+                            SWAP_op<T, std::memory_order_relaxed>, 
+                            FAA_op<T, std::memory_order_relaxed>, 
+                            store_op<T, std::memory_order_relaxed>>;
+
+template <typename T>
+using barr_ops2 = type_list<CAS_op<T, std::memory_order_relaxed>, 
+                            SWAP_op<T, std::memory_order_relaxed>, 
+                            FAA_op<T, std::memory_order_relaxed>, 
+                            load_op<T, std::memory_order_relaxed>>;
+
+// Counts of CAS loop attempts and failures
+struct cas_stats {
+    uint64_t attempts = 0;
+    uint64_t spurious = 0;    // failed, but the value was expected
+    uint64_t mismatch = 0;    // failed, the value was changed
+};
+
+// CAS_loop: Increment by read-modify-CAS loop until success
+template <typename T, std::memory_order MO>
+inline void CAS_loop(atomic_type<T> &atvar, cas_stats &stats)
 {
-    loaded[ithr].var = atarr[ithr].atvar.exchange(des[ithr].var,
-                                                  std::memory_order_relaxed);
+    T old = atvar.load(std::memory_order_relaxed);
+
+    for (;;) {
+        const T cur = old;
+
+        stats.attempts++;
+
+        if (atvar.compare_exchange_weak(old, T(cur + 1), MO))
+            return;
+
+        if (old == cur)
+            stats.spurious++;
+        else
+            stats.mismatch++;
+    }
 }
 
-inline void FAA_barr(int ithr)
+// Contended attempts for backoff policies: return false on failure 
+// (CAS) or if other thread modified the variable since the previous 
+// operation of this thread (FAA, SWAP). last is the value written by 
+// the previous operation of the thread in this run (reset together with 
+// the variable by the caller)
+
+// CAS_attempt: Single attempt of CAS loop increment
+template <typename T, std::memory_order MO>
+inline bool CAS_attempt(int ithr, uint64_t &)
 {
-    atarr[ithr].atvar.fetch_add(1, std::memory_order_relaxed);
+    auto &atvar = atarr<T>[ithr];
+    T old = atvar.load(std::memory_order_relaxed);
+
+    return atvar.compare_exchange_weak(old, T(old + 1), MO);
 }
 
-inline void load_barr(int ithr)
+template <typename T, std::memory_order MO>
+inline bool FAA_attempt(int ithr, uint64_t &last)
 {
-    loaded[ithr].var = atarr[ithr].atvar.load(std::memory_order_relaxed);
+    const T old = atarr<T>[ithr].fetch_add(T(1), MO);
+    const auto ok = (old == T(last));
+
+    last = T(old + 1);
+    return ok;
 }
 
-inline void store_barr(int ithr)
+template <typename T, std::memory_order MO>
+inline bool SWAP_attempt(int ithr, uint64_t &)
 {
-    atarr[ithr].atvar.store(des[ithr].var, std::memory_order_relaxed);
+    // Value unique to this thread
+    const T mine = T(results_ithr + 1);
+
+    return atarr<T>[ithr].exchange(mine, MO) == mine;
 }
 
+///////////////////////////////////////////////////////////
+//                 Fences
 ///////////////////////////////////////////////////////////
 
-std::random_device rd;
-std::mt19937 gen(rd());
+// Fences between operations in barrier suite (functors, as operations)
 
-// dodelay: Sleep for normally-distributed timeout
-inline void dodelay(int delay)
-{
-    std::normal_distribution<> norm_dist{double(delay), double(delay / 10)};
-    const auto timeout = std::lround(norm_dist(gen));
-    std::this_thread::sleep_for(std::chrono::nanoseconds(timeout));
+// fence_none: No fence (the compiler may reorder operations)
+struct fence_none {
+    static constexpr auto name = "none";
+    void operator()() const {}
+};
 
-    // usleep(timeout);
-}
+// fence_compiler: Compiler barrier only
+struct fence_compiler {
+    static constexpr auto name = "compiler";
+    void operator()() const { asm volatile("" ::: "memory"); }
+};
 
-// output: Print elapsed / avg time
-void output(double sumtime, const std::string &atop_name, 
-            const std::string &MESI_state, int nthr, int ithr,
-            int delay, int stride, const std::string &test_type)
-{
-    auto avgtime = sumtime / nruns;
+// fence_thread: std::atomic_thread_fence(seq_cst)
+struct fence_thread {
+    static constexpr auto name = "thread_fence";
 
-    std::lock_guard<std::mutex> lock(mut);
+    void operator()() const
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+};
 
-    std::string key = std::to_string(nthr) + atop_name + MESI_state + 
-                      std::to_string(delay) + std::to_string(stride);
+// fence_signal: std::atomic_signal_fence(seq_cst) (compiler barrier)
+struct fence_signal {
+    static constexpr auto name = "signal_fence";
 
-    auto search = avgtime_sum.find(key);
-    
-    if (search == avgtime_sum.end()) {
-        avgtime_val val{test_type, atop_name, MESI_state, nthr, 
-                        delay, stride, avgtime};
-        std::pair<std::string, avgtime_val> elem(key, val);
-        avgtime_sum.insert(elem);
-    } else {
-        auto avgtime_prev = search->second.time;
-        avgtime_val val{test_type, atop_name, MESI_state, nthr, 
-                        delay, stride, avgtime_prev + avgtime};
-        search->second = val;
+    void operator()() const
+    {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
     }
+};
 
-    std::cout << "nthr " << nthr << " ithr " << ithr << " delay " 
-              << delay << " " << " stride " << stride << " " << atop_name 
-              << " MESI state " << MESI_state << ": " << avgtime << std::endl;
-}
+// Hardware fences are x86 instructions, use the portable fence elsewhere
+#if defined(__x86_64__) || defined(__i386__)
 
-// TODO combine _shared and _notshared into one
+struct fence_mfence {
+    static constexpr auto name = "mfence";
+    void operator()() const { asm volatile("mfence" ::: "memory"); }
+};
 
-// meas_simple: Measure without specified MESI state
-void meas_simple(void (*atop)(int), const std::string &atop_name, 
-                 int nthr, int ithr, int delay, const std::string &test_type)
-{
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+// fence_lock_add: Locked add of zero to the stack top (full barrier)
+struct fence_lock_add {
+    static constexpr auto name = "lock_add";
 
-    if ((test_type == "delay_shared") || (test_type == "contention_shared")) {
-        // All threads access to one 0th atomic variable
-        ithr = 0;
+    void operator()() const
+    {
+#ifdef __x86_64__
+        asm volatile("lock; addl $0, (%%rsp)" ::: "memory", "cc");
+#else
+        asm volatile("lock; addl $0, (%%esp)" ::: "memory", "cc");
+#endif
     }
+};
 
-    for (auto i = 0; i < nruns; i++) {
-        start = get_time();
-        atop(ithr);
-        end = get_time();
+struct fence_sfence {
+    static constexpr auto name = "sfence";
+    void operator()() const { asm volatile("sfence" ::: "memory"); }
+};
 
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+struct fence_lfence {
+    static constexpr auto name = "lfence";
+    void operator()() const { asm volatile("lfence" ::: "memory"); }
+};
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
+#else
 
-        // Strange, but calling a function (instead for-loop) decreases 
-        // the latency of atomic operations, making it equal for all delays
-        // dodelay(delay);
+struct fence_mfence: fence_thread { static constexpr auto name = "mfence"; };
+struct fence_lock_add: fence_thread 
+    { static constexpr auto name = "lock_add"; };
+struct fence_sfence: fence_thread { static constexpr auto name = "sfence"; };
+struct fence_lfence: fence_thread { static constexpr auto name = "lfence"; };
 
-        // Loop making a delay
-        for (auto j = 0; j < delay; j++);
-    }
-    
-    const auto stride = 0;
+#endif
 
-    if (test_type == "delay_shared") 
-        output(sumtime, atop_name, "DS", nthr, ithr, delay, stride, test_type);
-    else if (test_type == "delay_notshared") 
-        output(sumtime, atop_name, "DN", nthr, ithr, delay, stride, test_type);
-    else if (test_type == "contention_shared") 
-        output(sumtime, atop_name, "CS", nthr, ithr, delay, stride, test_type);
-    else if (test_type == "contention_notshared") 
-        output(sumtime, atop_name, "CN", nthr, ithr, delay, stride, test_type);
-}
+using fence_types = type_list<fence_none, fence_compiler, fence_mfence, 
+                              fence_lock_add, fence_sfence, fence_lfence, 
+                              fence_thread, fence_signal>;
 
 ///////////////////////////////////////////////////////////
-//                 State M (Modified)
+//                 Measurement kernels
 ///////////////////////////////////////////////////////////
 
-// meas_M: Measure Modified state
-void meas_M(void (*atop)(int), const std::string &atop_name, 
-            const std::string &test_type,
-            std::future<void> &affin_ready_fut)
-{
-    affin_ready_fut.wait();
-
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+// Kernels are timed regions instantiated for operation functors: the
+// kernel is called through a pointer, operands are resolved before 
+// timer_start() and the operation is inlined between timer_start() and 
+// timer_stop() (see 'make asm')
 
-    const auto ithr = 0;
+// Timed kernel on the variable of thread ithr, returns time (ns)
+using timed_kernel_t = double (*)(int ithr);
 
-    for (auto i = 0; i < nruns; i++) {
-        // Write var to set M (Modified) state
-        atarr[ithr].atvar.store(val[ithr].var);
+// timed_region: Time f() (the region contains only the code of f), 
+//               events are counted around the region if counters of 
+//               the thread are started
+template <typename F>
+inline double timed_region(F f)
+{
+    auto &counters = thread_counters;
 
-        start = get_time();
-        atop(ithr);
-        end = get_time();
-        
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+    counters.resume();
+    const auto start = timer_start();
+    f();
+    const auto end = timer_stop();
+    counters.pause();
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
-    }
-    
-    output(sumtime, atop_name, "M", 1, ithr, 0, 0, test_type);
+    return timer_elapsed(start, end);
 }
 
-///////////////////////////////////////////////////////////
-//                 State E (Exclusive)
-///////////////////////////////////////////////////////////
+// empty_region: Timed region without operations (overhead of counters)
+void empty_region()
+{
+    timed_region([]{});
+}
 
-// meas_E: Measure Modified state
-void meas_E(void (*atop)(int), const std::string &atop_name, 
-            const std::string &test_type,
-            std::shared_future<void> affin_ready_fut)
+// timed_op: One operation
+template <typename Op>
+double timed_op(int ithr)
 {
-    affin_ready_fut.wait();
+    const Op op{};
+    const auto opnd = var_operands<typename Op::type>(ithr);
 
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+    return timed_region([=]{ op(opnd); });
+}
 
-    const auto ithr = 0;
+// timed_arr: One operation on ind-th element of the buffer
+template <typename Op>
+double timed_arr(int ithr, int ind)
+{
+    const Op op{};
+    const auto opnd = buf_operands<typename Op::type>(ithr, ind);
 
-    for (auto i = 0; i < nruns; i++) {
-        // Send a signal to prep_E
-        meas_ready = true;
+    return timed_region([=]{ op(opnd); });
+}
 
-        // Wait until prep_E will invalidate cache-line
-        while (prep_ready == false) {}
+// timed_chase: One operation on ind-th element of the chase buffer, ind
+//              is advanced to the next element stored in this one (the 
+//              address of the next operation depends on the load)
+template <typename Op>
+double timed_chase(int ithr, uint32_t &ind)
+{
+    using T = typename Op::type;
 
-        // Unset flag for reuse
-        prep_ready = false;
-        
-        // Read var to set E (Exclusive) state
-        loaded[ithr].var = atarr[ithr].atvar.load();
+    const Op op{};
+    const auto opnd = chase_operands<T>(ithr, ind);
 
-        start = get_time();
-        atop(ithr);
-        end = get_time();
-        
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+    const auto elapsed = timed_region([=]{ op(opnd); });
+    ind = atchase<T>[ithr][ind].next;
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
-    }
-    
-    output(sumtime, atop_name, "E", 1, ithr, 0, 0, test_type);
+    return elapsed;
 }
 
-// prep_E: Set Invalid state
-void prep_E(std::shared_future<void> affin_ready_fut)
+// unroll: Make operation K times back-to-back (unrolled at compile time)
+template <typename Op, typename T, int... I>
+inline void unroll(const Op &op, const operands<T> &opnd, 
+                   std::integer_sequence<int, I...>)
 {
-    affin_ready_fut.wait();
+    ((void(I), op(opnd)), ...);
+}
 
-    const auto ithr = 0;
+// timed_batch: K back-to-back operations. Operations after the first 
+//              expect the value written by the previous one, so each CAS
+//              of the batch succeeds (unless other thread intervenes)
+template <typename Op, int K>
+double timed_batch(int ithr)
+{
+    const Op op{};
+    const auto opnd = var_operands<typename Op::type>(ithr);
 
-    for (auto i = 0; i < nruns; i++) {
-        // Wait while meas_E will be ready
-        while (meas_ready == false) {}
+    auto next = opnd;
+    next.exptd = opnd.des;
 
-        // Unset meas flag for reuse
-        meas_ready = false;
-        
-        // Invalidate cache-line
-        atarr[ithr].atvar.store(val[ithr].var);
+    return timed_region([=]{ 
+        op(opnd);
+        unroll(op, next, std::make_integer_sequence<int, K - 1>{}); 
+    });
+}
 
-        // Signal to meas_E
-        prep_ready.store(true);
-    }
+// timed_pair: Pair of operations separated by the fence
+template <typename Op1, typename Op2, typename Fence>
+double timed_pair(int ithr)
+{
+    const Op1 op1{};
+    const Op2 op2{};
+    const Fence fence{};
+    const auto opnd = var_operands<typename Op1::type>(ithr);
+
+    return timed_region([=]{
+        op1(opnd);
+        fence();
+        op2(opnd);
+    });
 }
 
-///////////////////////////////////////////////////////////
-//                 State I (Invalid)
-///////////////////////////////////////////////////////////
+// timed_cas_loop: CAS loop increment of the variable of thread ithr
+template <typename T, std::memory_order MO>
+double timed_cas_loop(int ithr, cas_stats &stats)
+{
+    const auto var = &atarr<T>[ithr];
 
-// meas_I: Measure Invalid state
-void meas_I(void (*atop)(int), const std::string &atop_name, 
-            const std::string &test_type, 
-            std::shared_future<void> affin_ready_fut)
+    return timed_region([=, &stats]{ CAS_loop<T, MO>(*var, stats); });
+}
+
+// chunk_op: tput_chunk operations of throughput run (not timed)
+template <typename Op>
+void chunk_op(int ithr)
 {
-    affin_ready_fut.wait();
+    const Op op{};
+    const auto opnd = var_operands<typename Op::type>(ithr);
 
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+    for (auto i = 0; i < tput_chunk; i++)
+        op(opnd);
+}
 
-    const auto ithr = 0;
+// Kernels of an operation
+struct atop_kernels {
+    std::string name;
 
-    for (auto i = 0; i < nruns; i++) {
-        // Send a signal to prep_I
-        meas_ready = true;
+    // Single operation on scalar variable and on element of the buffer
+    timed_kernel_t timed = nullptr;
+    double (*timed_arr)(int ithr, int ind) = nullptr;
 
-        // Wait for prep_I thread
-        while (prep_ready == false) {}
+    // Single operation on element of the chase buffer (advances ind)
+    double (*timed_chase)(int ithr, uint32_t &ind) = nullptr;
 
-        // Unset flag for reuse
-        prep_ready = false;
+    // Batches of sizes from batch_sizes
+    std::array<timed_kernel_t, batch_sizes::size()> timed_batch{};
 
-        start = get_time();
-        atop(ithr);
-        end = get_time();
+    // Operations of throughput run
+    void (*chunk)(int ithr) = nullptr;
+};
 
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+// Kernels of a pair of operations with each fence between them
+struct pair_kernels {
+    std::string name1;
+    std::string name2;
+    std::vector<std::pair<std::string, timed_kernel_t>> fences;
+};
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
-    }
+// make_batch_kernels: Batch kernels of operation for all batch sizes
+template <typename Op, int... K>
+std::array<timed_kernel_t, sizeof...(K)> 
+make_batch_kernels(std::integer_sequence<int, K...>)
+{
+    return {timed_batch<Op, K>...};
+}
 
-    output(sumtime, atop_name, "I", 1, ithr, 0, 0, test_type);
+// make_kernels: Kernels of operation
+template <typename Op>
+atop_kernels make_kernels()
+{
+    atop_kernels kernels;
+
+    kernels.name = Op::name;
+    kernels.timed = timed_op<Op>;
+    kernels.timed_arr = timed_arr<Op>;
+    kernels.timed_chase = timed_chase<Op>;
+    kernels.timed_batch = make_batch_kernels<Op>(batch_sizes{});
+    kernels.chunk = chunk_op<Op>;
+
+    return kernels;
 }
 
-// prep_I: Set Invalid state
-void prep_I(std::shared_future<void> affin_ready_fut)
+// add_kernels: Append kernels of all operations of the type list
+template <typename... Ops>
+void add_kernels(std::vector<atop_kernels> &kernels, type_list<Ops...>)
 {
-    affin_ready_fut.wait();
+    (kernels.push_back(make_kernels<Ops>()), ...);
+}
 
-    const auto ithr = 0;
+// make_pair_kernels: Kernels of pair of operations for all fences
+template <typename Op1, typename Op2, typename... Fences>
+pair_kernels make_pair_kernels(type_list<Fences...>)
+{
+    return {Op1::name, Op2::name, 
+            {{Fences::name, timed_pair<Op1, Op2, Fences>}...}};
+}
 
-    for (auto i = 0; i < nruns; i++) {
-        // Wait until meas_I will send a signal
-        while (meas_ready == false) {}
+// add_pair_kernels: Append kernels of pairs (Op1, op2) for all op2 
+//                   of the type list
+template <typename Op1, typename... Ops2>
+void add_pair_kernels(std::vector<pair_kernels> &kernels, type_list<Ops2...>)
+{
+    (kernels.push_back(make_pair_kernels<Op1, Ops2>(fence_types{})), ...);
+}
 
-        // Unset flag for reuse
-        meas_ready = false;
+// make_barr_kernels: Kernels of all pairs of operations of two lists
+template <typename... Ops1, typename Ops2>
+std::vector<pair_kernels> make_barr_kernels(type_list<Ops1...>, Ops2 ops2)
+{
+    std::vector<pair_kernels> kernels;
 
-        // Invalidate cache-line
-        atarr[ithr].atvar.store(val[ithr].var);
+    (add_pair_kernels<Ops1>(kernels, ops2), ...);
 
-        // Send a signal to meas_I
-        prep_ready = true;
-    }
+    return kernels;
 }
 
 ///////////////////////////////////////////////////////////
-//                 State S (Shared)
+//                 Operand widths
 ///////////////////////////////////////////////////////////
 
-// meas_S: Measure Shared state
-void meas_S(void (*atop)(int), const std::string &atop_name, 
-            const std::string &test_type, 
-            std::shared_future<void> affin_ready_fut)
-{
-    affin_ready_fut.wait();
+// Contended attempt and whether the failed attempt is retried
+struct attempt_elem_t {
+    std::string name;
+    bool (*attempt)(int ithr, uint64_t &last);
+    bool retry;
+};
 
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+// Operation tables and test variable helpers of one operand width
+// and memory order
+struct width_ops {
+    int bits = 32;
 
-    const auto ithr = 0;
+    std::memory_order order = std::memory_order_seq_cst;
 
-    for (auto i = 0; i < nruns; i++) {
-        // Send a signal to prep_E
-        meas_ready = true;
+    // Kernels of atomic operations (scalar and buffer) and of pairs of
+    // operations (barrier)
+    std::vector<atop_kernels> atops;
+    std::vector<pair_kernels> atops_barr;
 
-        // Wait until prep_E will invalidate cache-line
-        while (prep_ready == false) {}
+    // Timed CAS loop increment
+    double (*cas_loop)(int ithr, cas_stats &stats) = nullptr;
 
-        // Unset flag for reuse
-        prep_ready = false;
+    // Contended attempts for backoff policies
+    std::vector<attempt_elem_t> attempts;
 
-        // Read var to set S (Shared) state
-        loaded[ithr].var = atarr[ithr].atvar.load();
+    // Restore atomic variable of thread ithr
+    void (*reset)(int ithr) = nullptr;
 
-        start = get_time();
-        atop(ithr);
-        end = get_time();
+    // Write atomic variable of thread ithr (M state)
+    void (*modify)(int ithr) = nullptr;
 
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+    // Read atomic variable of thread ithr into loaded[into]
+    void (*read)(int ithr, int into) = nullptr;
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
+    // Flush atomic variable of thread ithr from all caches
+    void (*flush)(int ithr) = nullptr;
 
-        prepflag.store(true);
-    }
+    // Place atomic variables of nthr threads spacing bytes apart
+    void (*space)(int nthr, size_t spacing) = nullptr;
 
-    output(sumtime, atop_name, "S", 1, ithr, 0, 0, test_type);
-}
+    // Allocate buffers of nthr threads of count elements
+    void (*buffer)(int nthr, size_t count) = nullptr;
 
-// prep_S: Set Shared state
-void prep_S(std::shared_future<void> affin_ready_fut)
+    // Load all elements of the buffer of thread ithr (warm-up)
+    void (*touch)(int ithr) = nullptr;
+
+    // Allocate chase buffers of nthr threads of size bytes (0 - free),
+    // returns number of elements of a buffer
+    size_t (*chase)(int nthr, size_t size) = nullptr;
+
+    // Load all elements of the chase buffer of thread ithr (warm-up)
+    void (*touch_chase)(int ithr) = nullptr;
+
+    // Address of atomic variable (buffer if buf) of thread ithr
+    const void *(*addr)(int ithr, bool buf) = nullptr;
+
+    // Allocate and free test variables for nthr threads
+    void (*init)(int nthr) = nullptr;
+    void (*free)() = nullptr;
+
+    // Fill scalar and buffer operation tables for memory order
+    void (*set_order)(width_ops &ops, std::memory_order order) = nullptr;
+};
+
+// Operation tables of current width and memory order (set by 
+// width_select() and order_select() before measurement threads start, 
+// so threads only read it)
+width_ops width;
+
+template <typename T>
+void reset_var(int ithr)
+{
+    atarr<T>[ithr] = T(atvar_def);
+}
+
+template <typename T>
+void modify_var(int ithr)
+{
+    atarr<T>[ithr].store(val<T>[ithr]);
+}
+
+template <typename T>
+void read_var(int ithr, int into)
+{
+    loaded<T>[into] = atarr<T>[ithr].load();
+}
+
+template <typename T>
+void flush_var(int ithr)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_clflush(&atarr<T>[ithr]);
+    __builtin_ia32_mfence();
+#endif
+}
+
+template <typename T>
+const void *var_addr(int ithr, bool buf)
+{
+    if (buf)
+        return &atbuf<T>[ithr][0];
+
+    return &atarr<T>[ithr];
+}
+
+// thread_node: NUMA node of memory of thread ithr under NUMA policy
+//              (mem_node_any - first touch, mem_node_all - interleaved)
+int thread_node(int ithr)
+{
+    switch (cfg.numa) {
+    case numa_policy::local: {
+        const auto cpu = thread_cpus.empty() ? 
+            ithr % int(std::thread::hardware_concurrency()) :
+            thread_cpus[ithr % thread_cpus.size()];
+
+        return cpu_online(cpu) ? cpu_find(cpu).node : mem_node_any;
+    }
+    case numa_policy::node:
+        return cfg.numa_node;
+    case numa_policy::interleave:
+        return mem_node_all;
+    default:
+        return mem_node_any;
+    }
+}
+
+// thread_nodes: NUMA nodes of memory of nthr threads
+std::vector<int> thread_nodes(int nthr)
+{
+    std::vector<int> nodes;
+
+    for (auto i = 0; i < nthr; i++)
+        nodes.push_back(thread_node(i));
+
+    return nodes;
+}
+
+// space_var: Place atomic variables of nthr threads spacing bytes apart
+//            (on NUMA nodes of threads)
+template <typename T>
+void space_var(int nthr, size_t spacing)
+{
+    atarr<T>.init(nthr, spacing, cfg.huge_pages);
+    atarr<T>.place(thread_nodes(nthr));
+
+    for (auto i = 0; i < nthr; i++)
+        atarr<T>[i] = T(atvar_def);
+}
+
+// init_buf: Allocate buffers of nthr threads of count elements
+//           (page-aligned, elements are packed)
+template <typename T>
+void init_buf(int nthr, size_t count)
+{
+    atbuf<T> = std::vector<spaced_array<atomic_type<T>>>(nthr);
+
+    for (auto i = 0; i < nthr; i++) {
+        atbuf<T>[i].init(count, sizeof(atomic_type<T>), cfg.huge_pages, 
+                         thread_node(i));
+
+        for (size_t j = 0; j < count; j++)
+            atbuf<T>[i][j] = T(atvar_def);
+    }
+}
+
+// touch_buf: Load all elements of the buffer of thread ithr
+template <typename T>
+void touch_buf(int ithr)
+{
+    auto &buf = atbuf<T>[ithr];
+
+    for (size_t i = 0; i < buf.size(); i++)
+        loaded<T>[ithr] = buf[i].load(std::memory_order_relaxed);
+}
+
+// init_chase: Allocate chase buffers of nthr threads of size bytes,
+//             elements of each buffer are linked in a random cycle
+//             (seeded by thread number). Returns number of elements
+template <typename T>
+size_t init_chase(int nthr, size_t size)
+{
+    const auto count = std::max(size / sizeof(chase_elem<T>), size_t(1));
+
+    atchase<T> = std::vector<spaced_array<chase_elem<T>>>(nthr);
+
+    for (auto i = 0; i < nthr; i++) {
+        auto &buf = atchase<T>[i];
+        const auto next = rand_chain(count, i);
+
+        buf.init(count, sizeof(chase_elem<T>), cfg.huge_pages, 
+                 thread_node(i));
+
+        for (size_t j = 0; j < count; j++) {
+            buf[j].var = T(atvar_def);
+            buf[j].next = next[j];
+        }
+    }
+
+    return count;
+}
+
+// touch_chase: Load all elements of the chase buffer of thread ithr
+template <typename T>
+void touch_chase(int ithr)
+{
+    auto &buf = atchase<T>[ithr];
+
+    for (size_t i = 0; i < buf.size(); i++)
+        loaded<T>[ithr] = buf[i].var.load(std::memory_order_relaxed);
+}
+
+// init_width_data: Allocate and initialize test arrays and buffers
+//                  of type T for nthr threads
+template <typename T>
+void init_width_data(int nthr)
+{
+    const auto atvar_spacing = spacing_bytes(cfg.spacing, 
+                                             sizeof(atomic_type<T>), 
+                                             cfg.huge_pages);
+    const auto var_spacing = spacing_bytes(cfg.spacing, sizeof(T), 
+                                           cfg.huge_pages);
+
+    space_var<T>(nthr, atvar_spacing);
+
+    exptd<T>.init(nthr, var_spacing, cfg.huge_pages);
+    des<T>.init(nthr, var_spacing, cfg.huge_pages);
+    des2<T>.init(nthr, var_spacing, cfg.huge_pages);
+    loaded<T>.init(nthr, var_spacing, cfg.huge_pages);
+    val<T>.init(nthr, var_spacing, cfg.huge_pages);
+
+    const auto nodes = thread_nodes(nthr);
+
+    exptd<T>.place(nodes);
+    des<T>.place(nodes);
+    des2<T>.place(nodes);
+    loaded<T>.place(nodes);
+    val<T>.place(nodes);
+
+    for (auto i = 0; i < nthr; i++) {
+        exptd<T>[i] = exptd_def;
+        des<T>[i] = des_def;
+        des2<T>[i] = des_def2;
+        loaded<T>[i] = loaded_def;
+        val<T>[i] = val_def;
+    }
+
+    init_buf<T>(nthr, atbuf_size);
+}
+
+// free_width_data: Free test arrays and buffers of type T
+template <typename T>
+void free_width_data()
+{
+    atarr<T>.free();
+    exptd<T>.free();
+    des<T>.free();
+    des2<T>.free();
+    loaded<T>.free();
+    val<T>.free();
+    std::vector<spaced_array<atomic_type<T>>>().swap(atbuf<T>);
+    std::vector<spaced_array<chase_elem<T>>>().swap(atchase<T>);
+}
+
+// make_order_ops: Scalar and buffer operation tables for operand type T
+//                 and memory order MO (load and store are left out for 
+//                 orders they do not allow)
+template <typename T, std::memory_order MO>
+void make_order_ops(width_ops &ops)
+{
+    ops.order = MO;
+
+    ops.cas_loop = timed_cas_loop<T, MO>;
+
+    ops.attempts = {{"CAS", CAS_attempt<T, MO>, true}, 
+                    {"FAA", FAA_attempt<T, MO>, false}, 
+                    {"SWAP", SWAP_attempt<T, MO>, false}};
+
+    ops.atops.clear();
+
+    add_kernels(ops.atops, rmw_ops<T, MO>{});
+
+    if constexpr (load_order_valid(MO))
+        add_kernels(ops.atops, type_list<load_op<T, MO>>{});
+
+    if constexpr (store_order_valid(MO))
+        add_kernels(ops.atops, type_list<store_op<T, MO>>{});
+}
+
+// set_order_ops: Fill operation tables of type T for memory order
+template <typename T>
+void set_order_ops(width_ops &ops, std::memory_order order)
+{
+    switch (order) {
+    case std::memory_order_relaxed: 
+        make_order_ops<T, std::memory_order_relaxed>(ops);
+        break;
+    case std::memory_order_acquire: 
+        make_order_ops<T, std::memory_order_acquire>(ops);
+        break;
+    case std::memory_order_release: 
+        make_order_ops<T, std::memory_order_release>(ops);
+        break;
+    case std::memory_order_acq_rel: 
+        make_order_ops<T, std::memory_order_acq_rel>(ops);
+        break;
+    default:
+        make_order_ops<T, std::memory_order_seq_cst>(ops);
+        break;
+    }
+}
+
+// make_width_ops: Operation tables for operand type T 
+//                 (scalar and buffer operations are seq_cst)
+template <typename T>
+width_ops make_width_ops(int bits)
+{
+    width_ops ops;
+
+    ops.bits = bits;
+
+    set_order_ops<T>(ops, std::memory_order_seq_cst);
+
+    ops.atops_barr = make_barr_kernels(barr_ops1<T>{}, barr_ops2<T>{});
+
+    ops.reset = reset_var<T>;
+    ops.modify = modify_var<T>;
+    ops.read = read_var<T>;
+    ops.flush = flush_var<T>;
+    ops.space = space_var<T>;
+    ops.buffer = init_buf<T>;
+    ops.touch = touch_buf<T>;
+    ops.chase = init_chase<T>;
+    ops.touch_chase = touch_chase<T>;
+    ops.addr = var_addr<T>;
+    ops.init = init_width_data<T>;
+    ops.free = free_width_data<T>;
+    ops.set_order = set_order_ops<T>;
+
+    return ops;
+}
+
+// width_ops_by_bits: Operation tables for operand width (bits)
+bool width_ops_by_bits(int bits, width_ops &ops)
+{
+    switch (bits) {
+    case 8:   ops = make_width_ops<uint8_t>(bits);   break;
+    case 16:  ops = make_width_ops<uint16_t>(bits);  break;
+    case 32:  ops = make_width_ops<uint32_t>(bits);  break;
+    case 64:  ops = make_width_ops<uint64_t>(bits);  break;
+    case 128: ops = make_width_ops<uint128_t>(bits); break;
+    default:  return false;
+    }
+
+    return true;
+}
+
+// width_lock_free: Check that operations of operand width are lock-free
+bool width_lock_free(int bits)
+{
+    switch (bits) {
+    case 8:   return atomic_lock_free<uint8_t>();
+    case 16:  return atomic_lock_free<uint16_t>();
+    case 32:  return atomic_lock_free<uint32_t>();
+    case 64:  return atomic_lock_free<uint64_t>();
+    case 128: return atomic_lock_free<uint128_t>();
+    default:  return false;
+    }
+}
+
+// width_check: Print lock-freedom of configured widths, leave only 
+//              lock-free widths in configuration
+void width_check()
+{
+    std::vector<int> widths;
+
+    for (auto bits: cfg.widths) {
+        const auto lock_free = width_lock_free(bits);
+
+        std::cout << "width " << bits << ": " 
+                  << (lock_free ? "lock-free" : "not lock-free, skipped")
+                  << std::endl;
+
+        if (lock_free)
+            widths.push_back(bits);
+    }
+
+    cfg.widths = widths;
+}
+
+// width_suffix: Suffix of data file names for operand width and memory
+//               order (empty for the default 32-bit width and seq_cst)
+std::string width_suffix(int bits, 
+                         std::memory_order order = std::memory_order_seq_cst)
+{
+    std::string suffix;
+
+    if (bits != 32)
+        suffix += "-w" + std::to_string(bits);
+
+    if (order != std::memory_order_seq_cst)
+        suffix += "-" + memory_order_name(order);
+
+    return suffix;
+}
+
+// name_register: Register name of test type, operation or MESI state
+//                (main thread only)
+int name_register(const std::string &name)
+{
+    auto it = std::find(names.begin(), names.end(), name);
+
+    if (it != names.end())
+        return it - names.begin();
+
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+// name_id: Id of registered name
+int name_id(const std::string &name)
+{
+    auto it = std::find(names.begin(), names.end(), name);
+
+    if (it == names.end()) {
+        std::cerr << "Unregistered name: " << name << std::endl;
+        exit(1);
+    }
+
+    return it - names.begin();
+}
+
+// cpu_mem_node: NUMA node of the CPU of calling thread (-1 if unknown)
+int cpu_mem_node()
+{
+    const auto cpu = sched_getcpu();
+
+    return ((cpu >= 0) && cpu_online(cpu)) ? cpu_find(cpu).node : -1;
+}
+
+// output_result: Save mean time (ns/op), throughput (Mops/s) and 
+//                histogram to the results of current thread
+//                (with NUMA node of memory at mem if it is given,
+//                counts of events per operation, access pattern and 
+//                buffer size of working set measurements)
+void output_result(double time, double rate, const histogram &hist,
+                   const std::string &atop_name, 
+                   const std::string &MESI_state, int nthr,
+                   int delay, int stride, const std::string &test_type,
+                   int batch = 1, const result_stats &stats = {},
+                   const void *mem = nullptr, 
+                   const counter_values &counters = {},
+                   const std::string &pattern = "none", int size_kb = 0)
+{
+    auto &res = results[results_ithr];
+
+    if (res.nslots == max_result_slots) {
+        std::cerr << "Too many results per thread" << std::endl;
+        exit(1);
+    }
+
+    auto &slot = res.slots[res.nslots++];
+
+    slot.key = result_key{uint16_t(name_id(test_type)), 
+                          uint16_t(name_id(atop_name)),
+                          uint16_t(name_id(MESI_state)), 
+                          uint16_t(width.bits), uint16_t(width.order), 
+                          uint16_t(nthr),
+                          delay, stride, batch, 
+                          uint16_t(name_id(pattern)), size_kb};
+    slot.time = time;
+    slot.rate = rate;
+    slot.hist = hist;
+    slot.stats = stats;
+    slot.mem_node = (mem != nullptr) ? mem_node(mem) : -1;
+    slot.remote = (slot.mem_node >= 0) && 
+                  (slot.mem_node != cpu_mem_node());
+    slot.counters = counters;
+}
+
+// output: Save avg time and histogram to the results of current thread
+//         (batch is the number of operations per timed region, ithr
+//         is the index of the measured variable or buffer), counts of
+//         events in timed regions since counters start are taken
+void output(double sumtime, const histogram &hist,
+            const std::string &atop_name, 
+            const std::string &MESI_state, int nthr, int ithr,
+            int delay, int stride, const std::string &test_type,
+            int batch = 1, const std::string &pattern = "none", 
+            int size_kb = 0)
+{
+    auto counters = thread_counters.stop();
+
+    auto avgtime = sumtime / (double(cfg.nruns) * batch);
+
+    for (auto &count: counters)
+        count /= double(cfg.nruns) * batch;
+
+    // Throughput of this thread (Mops/s)
+    auto rate = (avgtime > 0) ? 1e3 / avgtime : 0;
+
+    const auto buf = (test_type.compare(0, 4, "buf_") == 0) ||
+                     (test_type.compare(0, 5, "wset_") == 0);
+
+    // Test variables exist only if operand width is selected
+    const auto mem = (width.addr != nullptr) ? width.addr(ithr, buf) 
+                                             : nullptr;
+
+    output_result(avgtime, rate, hist, atop_name, MESI_state, nthr, 
+                  delay, stride, test_type, batch, {}, mem, counters, 
+                  pattern, size_kb);
+}
+
+// take_result: Mean time of the first result of thread ithr, results
+//              of the thread are dropped (main thread, after join)
+double take_result(int ithr)
+{
+    auto &res = results[ithr];
+    const auto time = (res.nslots > 0) ? res.slots[0].time : 0;
+
+    res.nslots = 0;
+    return time;
+}
+
+// reduce_results: Merge results of all threads after join
+void reduce_results()
+{
+    for (auto ithr = 0u; ithr < results.size(); ithr++) {
+        auto &res = results[ithr];
+
+        for (auto i = 0; i < res.nslots; i++) {
+            const auto &slot = res.slots[i];
+            const auto &key = slot.key;
+
+            auto search = avgtime_sum.find(key);
+            
+            if (search == avgtime_sum.end()) {
+                avgtime_val val{names[key.test], names[key.atop], 
+                                names[key.state], key.width, 
+                                std::memory_order(key.order), key.nthr, 
+                                key.delay, key.stride, key.batch, 
+                                names[key.pattern], key.size_kb, 1, 
+                                slot.time, slot.rate, slot.hist, 
+                                slot.stats, slot.mem_node, slot.remote,
+                                slot.counters};
+                avgtime_sum.emplace(key, val);
+            } else {
+                search->second.count++;
+                search->second.time += slot.time;
+                search->second.rate += slot.rate;
+                search->second.hist.merge(slot.hist);
+
+                for (auto j = 0; j < max_stats; j++)
+                    search->second.stats[j] += slot.stats[j];
+
+                if (search->second.mem_node != slot.mem_node)
+                    search->second.mem_node = -1;
+
+                search->second.remote += slot.remote;
+
+                for (auto j = 0; j < max_counters; j++)
+                    search->second.counters[j] += slot.counters[j];
+            }
+
+            std::cout << "width " << key.width << " order " 
+                      << memory_order_name(std::memory_order(key.order))
+                      << " nthr " << key.nthr << " ithr " << ithr 
+                      << " delay " << key.delay << " " << " stride " 
+                      << key.stride << " " << names[key.atop] 
+                      << " MESI state " << names[key.state] << ": " 
+                      << slot.time << " p99 " << slot.hist.percentile(0.99) 
+                      << std::endl;
+        }
+
+        res.nslots = 0;
+    }
+}
+
+// open_data_file: Data file for appending, a new file starts with
+//                 the build and run info comments and the header line 
+//                 (if any). Files are kept open by the sink until the end
+//                 of the suite (the stream is valid until the next call),
+//                 output is discarded if .dat files are off
+std::ostream &open_data_file(const std::string &fname, 
+                             const std::string &header = "")
+{
+    static std::ostream null_stream(nullptr);
+
+    if (!cfg.dat)
+        return null_stream;
+
+    return sink.dat(fname, {build_info(), run_info}, header);
+}
+
+// TODO combine _shared and _notshared into one
+
+// meas_simple: Measure without specified MESI state
+//              (delay is the mean delay between operations, ns)
+void meas_simple(timed_kernel_t timed, const std::string &atop_name, 
+                 int nthr, int ithr, int delay, const std::string &test_type)
+{
+    double sumtime = 0;
+    histogram hist;
+    delay_gen dgen(cfg.delay_dist, delay, ithr);
+
+    if ((test_type == "delay_shared") || (test_type == "contention_shared")) {
+        // All threads access to one 0th atomic variable
+        ithr = 0;
+    }
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = timed(ithr);
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+
+        dgen.wait();
+    }
+    
+    const auto stride = 0;
+
+    if (test_type == "delay_shared") 
+        output(sumtime, hist, atop_name, "DS", nthr, ithr, delay, stride,
+               test_type);
+    else if (test_type == "delay_notshared") 
+        output(sumtime, hist, atop_name, "DN", nthr, ithr, delay, stride,
+               test_type);
+    else if (test_type == "contention_shared") 
+        output(sumtime, hist, atop_name, "CS", nthr, ithr, delay, stride,
+               test_type);
+    else if (test_type == "contention_notshared") 
+        output(sumtime, hist, atop_name, "CN", nthr, ithr, delay, stride,
+               test_type);
+}
+
+///////////////////////////////////////////////////////////
+//                 Batch measurements
+///////////////////////////////////////////////////////////
+
+// meas_batch: Measure batch back-to-back operations per timed region
+//             (timed is the kernel of the batch size)
+void meas_batch(timed_kernel_t timed, int batch, const std::string &atop_name,
+                int nthr, int ithr, const std::string &test_type)
+{
+    double sumtime = 0;
+    histogram hist;
+
+    if (test_type == "batch_shared") {
+        // All threads access to one 0th atomic variable
+        ithr = 0;
+    }
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = timed(ithr);
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed / batch);
+    }
+
+    const auto delay = 0;
+    const auto stride = 0;
+
+    if (test_type == "batch_shared") 
+        output(sumtime, hist, atop_name, "BS", nthr, ithr, delay, stride, 
+               test_type, batch);
+    else if (test_type == "batch_notshared") 
+        output(sumtime, hist, atop_name, "BN", nthr, ithr, delay, stride, 
+               test_type, batch);
+}
+
+// meas_batch_sizes: Batch measurements for all batch sizes
+template <int... K>
+void meas_batch_sizes(const atop_kernels &kernels, int nthr, int ithr, 
+                      const std::string &test_type,
+                      std::integer_sequence<int, K...>)
+{
+    const std::array<int, sizeof...(K)> sizes{K...};
+
+    for (auto i = 0u; i < sizes.size(); i++) {
+        if (config_has(cfg.batches, sizes[i]))
+            meas_batch(kernels.timed_batch[i], sizes[i], kernels.name, 
+                       nthr, ithr, test_type);
+    }
+}
+
+// make_batch_meas: Experiments for throughput of operation streams
+void make_batch_meas(const atop_kernels &kernels, int nthr, int ithr)
+{
+    barr.wait(ithr);
+
+    meas_batch_sizes(kernels, nthr, ithr, "batch_shared", batch_sizes{});
+
+    meas_batch_sizes(kernels, nthr, ithr, "batch_notshared", batch_sizes{});
+}
+
+///////////////////////////////////////////////////////////
+//                 State M (Modified)
+///////////////////////////////////////////////////////////
+
+// meas_M: Measure Modified state
+void meas_M(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type,
+            std::future<void> &affin_ready_fut)
+{
+    affin_ready_fut.wait();
+    thread_counters.open(empty_region);
+
+    double sumtime = 0;
+    histogram hist;
+
+    const auto ithr = 0;
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Write var to set M (Modified) state
+        width.modify(ithr);
+
+        const auto elapsed = timed(ithr);
+        
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+    
+    output(sumtime, hist, atop_name, "M", 1, ithr, 0, 0, test_type);
+}
+
+///////////////////////////////////////////////////////////
+//                 State E (Exclusive)
+///////////////////////////////////////////////////////////
+
+// meas_E: Measure Modified state
+void meas_E(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type,
+            std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+    thread_counters.open(empty_region);
+
+    double sumtime = 0;
+    histogram hist;
+
+    const auto ithr = 0;
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Send a signal to prep_E
+        meas_ready = true;
+
+        // Wait until prep_E will invalidate cache-line
+        while (prep_ready == false) {}
+
+        // Unset flag for reuse
+        prep_ready = false;
+        
+        // Read var to set E (Exclusive) state
+        width.read(ithr, ithr);
+
+        const auto elapsed = timed(ithr);
+        
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+    
+    output(sumtime, hist, atop_name, "E", 1, ithr, 0, 0, test_type);
+}
+
+// prep_E: Set Invalid state
+void prep_E(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    const auto ithr = 0;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Wait while meas_E will be ready
+        while (meas_ready == false) {}
+
+        // Unset meas flag for reuse
+        meas_ready = false;
+        
+        // Invalidate cache-line
+        width.modify(ithr);
+
+        // Signal to meas_E
+        prep_ready.store(true);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 State I (Invalid)
+///////////////////////////////////////////////////////////
+
+// meas_prepared: Measure the state set by preparation thread(s)
+void meas_prepared(timed_kernel_t timed, const std::string &atop_name, 
+                   const std::string &MESI_state,
+                   const std::string &test_type, 
+                   std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+    thread_counters.open(empty_region);
+
+    double sumtime = 0;
+    histogram hist;
+
+    const auto ithr = 0;
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Send a signal to preparation thread
+        meas_ready = true;
+
+        // Wait for preparation thread
+        while (prep_ready == false) {}
+
+        // Unset flag for reuse
+        prep_ready = false;
+
+        const auto elapsed = timed(ithr);
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+
+    output(sumtime, hist, atop_name, MESI_state, 1, ithr, 0, 0, test_type);
+}
+
+// meas_I: Measure Invalid state
+void meas_I(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type, 
+            std::shared_future<void> affin_ready_fut)
+{
+    meas_prepared(timed, atop_name, "I", test_type, affin_ready_fut);
+}
+
+// prep_I: Set Invalid state
+void prep_I(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    const auto ithr = 0;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Wait until meas_I will send a signal
+        while (meas_ready == false) {}
+
+        // Unset flag for reuse
+        meas_ready = false;
+
+        // Invalidate cache-line
+        width.modify(ithr);
+
+        // Send a signal to meas_I
+        prep_ready = true;
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 State S (Shared)
+///////////////////////////////////////////////////////////
+
+// meas_S: Measure Shared state
+void meas_S(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type, 
+            std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+    thread_counters.open(empty_region);
+
+    double sumtime = 0;
+    histogram hist;
+
+    const auto ithr = 0;
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Send a signal to prep_E
+        meas_ready = true;
+
+        // Wait until prep_E will invalidate cache-line
+        while (prep_ready == false) {}
+
+        // Unset flag for reuse
+        prep_ready = false;
+
+        // Read var to set S (Shared) state
+        width.read(ithr, ithr);
+
+        const auto elapsed = timed(ithr);
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+
+        prepflag.store(true);
+    }
+
+    output(sumtime, hist, atop_name, "S", 1, ithr, 0, 0, test_type);
+}
+
+// prep_S: Set Shared state
+void prep_S(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    // Measurement thread index
+    const auto ithr = 0;
+
+    // Preparation thread index
+    const auto prep_ithr = 1;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Wait while meas_S will be ready
+        while (meas_ready == false) {}
+
+        // Unset meas flag for reuse
+        meas_ready = false;
+
+        // Read to set E state
+        width.read(ithr, prep_ithr);
+
+        // Signal to meas_E
+        prep_ready.store(true);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 State O (Owned) and F (Forward)
+///////////////////////////////////////////////////////////
+
+// Flags to synchronize preparation and reader threads
+std::atomic<bool> reader_go(false);
+std::atomic<bool> reader_done(false);
+
+// meas_O: Measure Owned state (dirty line shared with other cores)
+void meas_O(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type, 
+            std::shared_future<void> affin_ready_fut)
+{
+    meas_prepared(timed, atop_name, "O", test_type, affin_ready_fut);
+}
+
+// meas_F: Measure Forward state (clean line shared with other cores)
+void meas_F(timed_kernel_t timed, const std::string &atop_name, 
+            const std::string &test_type, 
+            std::shared_future<void> affin_ready_fut)
+{
+    meas_prepared(timed, atop_name, "F", test_type, affin_ready_fut);
+}
+
+// run_reader: Let reader thread read the line and wait for it
+inline void run_reader()
+{
+    reader_go = true;
+
+    while (reader_done == false) {}
+
+    reader_done = false;
+}
+
+// prep_O: Set Owned state: the line is modified by preparation thread
+//         and then read by reader thread (O in preparation thread 
+//         on MOESI, S/F on MESIF)
+void prep_O(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    const auto ithr = 0;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Wait while meas_O will be ready
+        while (meas_ready == false) {}
+
+        // Unset meas flag for reuse
+        meas_ready = false;
+
+        // Modify cache-line
+        width.modify(ithr);
+
+        // Share dirty cache-line with reader
+        run_reader();
+
+        // Signal to meas_O
+        prep_ready = true;
+    }
+}
+
+// prep_F: Set Forward state: the line is written back to memory, then
+//         read by preparation thread and by reader thread
+//         (F in the reader thread on MESIF)
+void prep_F(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    const auto ithr = 0;
+
+    // Preparation thread index
+    const auto prep_ithr = 1;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        // Wait while meas_F will be ready
+        while (meas_ready == false) {}
+
+        // Unset meas flag for reuse
+        meas_ready = false;
+
+        // Write cache-line back and invalidate it in all caches
+        width.modify(ithr);
+        width.flush(ithr);
+
+        // Read clean cache-line (E state), then share it with reader
+        width.read(ithr, prep_ithr);
+        run_reader();
+
+        // Signal to meas_F
+        prep_ready = true;
+    }
+}
+
+// prep_reader: Read the line on request of preparation thread
+void prep_reader(std::shared_future<void> affin_ready_fut)
+{
+    affin_ready_fut.wait();
+
+    const auto ithr = 0;
+
+    // Reader thread index
+    const auto reader_ithr = 2;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        while (reader_go == false) {}
+
+        reader_go = false;
+
+        width.read(ithr, reader_ithr);
+
+        reader_done = true;
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 Remote M (Modified) states
+///////////////////////////////////////////////////////////
+
+// meas_RM: Measure line modified on the other socket
+void meas_RM(timed_kernel_t timed, const std::string &atop_name, 
+             const std::string &test_type, 
+             std::shared_future<void> affin_ready_fut)
+{
+    meas_prepared(timed, atop_name, "RM", test_type, affin_ready_fut);
+}
+
+// meas_RL3: Measure line modified in other L3 of the same socket
+void meas_RL3(timed_kernel_t timed, const std::string &atop_name, 
+              const std::string &test_type, 
+              std::shared_future<void> affin_ready_fut)
+{
+    meas_prepared(timed, atop_name, "RL3", test_type, affin_ready_fut);
+}
+
+///////////////////////////////////////////////////////////
+//                 Contention functions
+///////////////////////////////////////////////////////////
+
+// make_cont_meas: Experiments for contention measurements
+//                 Many threads make operations with one atomic variables
+//                 (MESI state is undefined)
+void make_cont_meas(timed_kernel_t timed, const std::string &atop_name, 
+                    int nthr, int ithr)
+{
+    barr.wait(ithr);
+
+    const auto delay = 0;
+    meas_simple(timed, atop_name, nthr, ithr, delay, 
+                "contention_shared");
+
+    meas_simple(timed, atop_name, nthr, ithr, delay,
+                "contention_notshared");
+}
+
+///////////////////////////////////////////////////////////
+//                 Throughput measurements
+///////////////////////////////////////////////////////////
+
+// Flags to start and stop all threads of throughput measurement
+std::atomic<bool> tput_start(false);
+std::atomic<bool> tput_stop(false);
+
+// Number of completed operations of a thread
+struct alignas(64) tput_counter {
+    uint64_t ops = 0;
+};
+
+std::vector<tput_counter> tput_ops;
+
+// tput_run: Call step(), which makes tput_chunk operations, on all nthr 
+//           threads for cfg.duration ms. Thread 0 raises start flag and 
+//           stop flag when the duration expires. Operations are counted 
+//           in tput_ops[ithr], returns elapsed time (ns) of the thread
+template <typename F>
+double tput_run(int ithr, F step)
+{
+    auto &counter = tput_ops[ithr];
+    const auto duration = ticks_t(cfg.duration) * 1'000'000;
+
+    counter.ops = 0;
+
+    barr.wait(ithr);
+
+    if (ithr == 0)
+        tput_start = true;
+    else
+        while (tput_start.load(std::memory_order_acquire) == false) {}
+
+    const auto start = steady_ticks();
+
+    while (tput_stop.load(std::memory_order_relaxed) == false) {
+        step();
+
+        counter.ops += tput_chunk;
+
+        if ((ithr == 0) && (steady_ticks() - start >= duration))
+            tput_stop = true;
+    }
+
+    const auto elapsed = double(steady_ticks() - start);
+
+    // Reset flags for the next measurement
+    barr.wait(ithr);
+
+    if (ithr == 0) {
+        tput_start = false;
+        tput_stop = false;
+    }
+
+    barr.wait(ithr);
+
+    return elapsed;
+}
+
+// jain_index: Jain's fairness index of operation counts of nthr threads
+//             (1 if all threads made equal number of operations)
+double jain_index(int nthr)
+{
+    double sum = 0, sum_sq = 0;
+
+    for (auto i = 0; i < nthr; i++) {
+        const double ops = tput_ops[i].ops;
+        sum += ops;
+        sum_sq += ops * ops;
+    }
+
+    return (sum_sq > 0) ? sum * sum / (nthr * sum_sq) : 0;
+}
+
+// meas_tput: Measure the number of operations completed in 
+//            cfg.duration ms (chunk makes tput_chunk operations)
+void meas_tput(void (*chunk)(int), const std::string &atop_name, 
+               int nthr, int ithr, const std::string &test_type)
+{
+    auto var_ithr = ithr;
+
+    if (test_type == "tput_shared") {
+        // All threads access to one 0th atomic variable
+        var_ithr = 0;
+    }
+
+    const auto elapsed = tput_run(ithr, [=]{ chunk(var_ithr); });
+
+    // Restore atomic variable (other threads wait for the next run)
+    if (var_ithr == ithr)
+        width.reset(var_ithr);
+
+    const auto ops = tput_ops[ithr].ops;
+
+    // Latency (ns/op) and throughput (Mops/s) of this thread
+    const auto time = (ops > 0) ? elapsed / ops : 0;
+    const auto rate = (elapsed > 0) ? ops * 1e3 / elapsed : 0;
+
+    if (test_type == "tput_shared") 
+        output_result(time, rate, histogram(), atop_name, "TS", nthr, 
+                      0, 0, test_type);
+    else
+        output_result(time, rate, histogram(), atop_name, "TN", nthr, 
+                      0, 0, test_type);
+}
+
+// make_tput_meas: Experiments for throughput of fixed-duration runs
+void make_tput_meas(void (*chunk)(int), const std::string &atop_name, 
+                    int nthr, int ithr)
+{
+    meas_tput(chunk, atop_name, nthr, ithr, "tput_shared");
+
+    meas_tput(chunk, atop_name, nthr, ithr, "tput_notshared");
+}
+
+///////////////////////////////////////////////////////////
+//                 CAS loop measurements
+///////////////////////////////////////////////////////////
+
+// meas_casloop: Measure latency to success of CAS loop increments
+//               of the shared (0th) variable
+void meas_casloop(int nthr)
+{
+    double sumtime = 0;
+    histogram hist;
+    cas_stats stats;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = width.cas_loop(0, stats);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+
+    const result_stats counts{double(cfg.nruns), double(stats.attempts),
+                              double(stats.spurious), 
+                              double(stats.mismatch)};
+
+    const auto avgtime = sumtime / cfg.nruns;
+
+    output_result(avgtime, (avgtime > 0) ? 1e3 / avgtime : 0, hist, 
+                  "CAS_loop", "CL", nthr, 0, 0, "casloop", 1, counts);
+}
+
+// meas_rmw: Measure single read-modify-write operation on the shared
+//           (0th) variable, the variable is not restored as in CAS loop
+void meas_rmw(timed_kernel_t timed, const std::string &atop_name, int nthr)
+{
+    double sumtime = 0;
+    histogram hist;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = timed(0);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+
+    // Every operation succeeds in one attempt
+    const result_stats counts{double(cfg.nruns), double(cfg.nruns), 0, 0};
+
+    const auto avgtime = sumtime / cfg.nruns;
+
+    output_result(avgtime, (avgtime > 0) ? 1e3 / avgtime : 0, hist, 
+                  atop_name, "CL", nthr, 0, 0, "casloop", 1, counts);
+}
+
+// make_casloop_meas: Experiments for CAS loop compared with FAA and SWAP
+//                    (rmw_atops) on the same variable
+void make_casloop_meas(const std::vector<atop_kernels> &rmw_atops,
+                       int nthr, int ithr)
+{
+    barr.wait(ithr);
+
+    meas_casloop(nthr);
+
+    for (const auto &atop: rmw_atops) {
+        barr.wait(ithr);
+
+        meas_rmw(atop.timed, atop.name, nthr);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 Backoff measurements
+///////////////////////////////////////////////////////////
+
+// Lock of MCS backoff policy and queue nodes of threads
+mcs_lock backoff_lock;
+std::vector<mcs_node> backoff_nodes;
+
+// backoff_op: Make contended operation on the shared (0th) variable 
+//             with backoff policy. Failed attempt is retried if retry 
+//             is set (CAS), otherwise the thread only backs off
+inline void backoff_op(const attempt_elem_t &op, backoff_type type, 
+                       backoff &bo, mcs_node &node, uint64_t &last)
+{
+    if (type == backoff_type::mcs) {
+        backoff_lock.lock(node);
+        op.attempt(0, last);
+        backoff_lock.unlock(node);
+        return;
+    }
+
+    while (!op.attempt(0, last)) {
+        bo.fail();
+
+        if (!op.retry)
+            break;
+    }
+
+    bo.reset();
+}
+
+// meas_backoff: Measure throughput and fairness of contended operation
+//               with backoff policy for cfg.duration ms
+void meas_backoff(const attempt_elem_t &op, backoff_type type, 
+                  int nthr, int ithr)
+{
+    backoff bo(type, ithr);
+    auto &node = backoff_nodes[ithr];
+
+    // The variable is restored after each run
+    uint64_t last = atvar_def;
+
+    const auto elapsed = tput_run(ithr, [&]{
+        for (auto i = 0; i < tput_chunk; i++)
+            backoff_op(op, type, bo, node, last);
+    });
+
+    // Restore atomic variable (other threads wait for the next run)
+    if (ithr == 0)
+        width.reset(0);
+
+    const auto ops = tput_ops[ithr].ops;
+
+    const auto time = (ops > 0) ? elapsed / ops : 0;
+    const auto rate = (elapsed > 0) ? ops * 1e3 / elapsed : 0;
+
+    // Counters of all threads are final after tput_run()
+    const result_stats stats{jain_index(nthr), 0, 0, 0};
+
+    output_result(time, rate, histogram(), op.name, 
+                  backoff_type_name(type), nthr, 0, 0, "backoff", 1, stats);
+}
+
+// make_backoff_meas: Experiments for backoff policies
+void make_backoff_meas(const std::vector<attempt_elem_t> &ops, 
+                       const std::vector<backoff_type> &types, 
+                       int nthr, int ithr)
+{
+    for (const auto &op: ops) {
+        for (auto type: types)
+            meas_backoff(op, type, nthr, ithr);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 Lock measurements
+///////////////////////////////////////////////////////////
+
+// Data protected by the lock (incremented cfg.cs times in critical 
+// section)
+struct alignas(64) lock_data_t {
+    volatile uint64_t counter = 0;
+};
+
+lock_data_t lock_data;
+
+test_lock lck;
+
+// meas_lock: Measure acquire latency, throughput and fairness of the lock
+//            for cfg.duration ms
+void meas_lock(int nthr, int ithr)
+{
+    ticks_t start, end;
+    double sumtime = 0;
+    histogram hist;
+
+    if (ithr == 0)
+        lock_data.counter = 0;
+
+    const auto elapsed = tput_run(ithr, [&]{
+        for (auto i = 0; i < tput_chunk; i++) {
+            start = timer_start();
+            lck.acquire(ithr);
+            end = timer_stop();
+
+            // Critical section
+            for (auto j = 0; j < cfg.cs; j++)
+                lock_data.counter = lock_data.counter + 1;
+
+            lck.release(ithr);
+
+            const auto acq_time = timer_elapsed(start, end);
+            sumtime += acq_time;
+            hist.record(acq_time);
+        }
+    });
+
+    const auto ops = tput_ops[ithr].ops;
+
+    // Check mutual exclusion (counters of all threads are final)
+    if (ithr == 0) {
+        uint64_t total = 0;
+
+        for (auto i = 0; i < nthr; i++)
+            total += tput_ops[i].ops;
+
+        if (lock_data.counter != total * cfg.cs) {
+            std::cerr << "Lock " << lock_type_name(lck.get_type()) 
+                      << " is broken: counter " << lock_data.counter 
+                      << ", expected " << total * cfg.cs << std::endl;
+        }
+    }
+
+    const auto time = (ops > 0) ? sumtime / ops : 0;
+    const auto rate = (elapsed > 0) ? ops * 1e3 / elapsed : 0;
+
+    const result_stats stats{jain_index(nthr), 0, 0, 0};
+
+    output_result(time, rate, hist, lock_type_name(lck.get_type()), "LK", 
+                  nthr, 0, 0, "lock", 1, stats);
+}
+
+///////////////////////////////////////////////////////////
+//                 Delay measurement
+///////////////////////////////////////////////////////////
+
+// make_cont_meas: Experiments for contention measurements
+//                 Many threads make operations with one atomic variables
+//                 (MESI state is undefined)
+void make_delay_meas(timed_kernel_t timed, const std::string &atop_name, 
+                    int nthr, int ithr, int delay)
+{
+    barr.wait(ithr);
+
+    meas_simple(timed, atop_name, nthr, ithr, delay, 
+                "delay_shared");
+
+    // meas_simple_notshared(timed, atop_name, nthr, ithr, delay,
+    //                       "delay_notshared");
+}
+
+
+///////////////////////////////////////////////////////////
+//                 MESI measurements
+///////////////////////////////////////////////////////////
+
+using MESI_meas_func = std::function<void(timed_kernel_t, 
+                                         const std::string&,
+                                         const std::string&, 
+                                         std::shared_future<void>)>;
+
+using MESI_prep_func = std::function<void(std::shared_future<void>)>;
+
+// MESI_meas_prep: Make MESI measurement for specified state
+//                 by means of measurement and preparation threads
+//                 (only for E, S and I states) on meas_cpu and prep_cpu
+void MESI_do_meas(timed_kernel_t timed, const std::string &atop_name,
+                  MESI_meas_func meas, MESI_prep_func prep,
+                  const std::string &test_type = "MESI",
+                  int meas_cpu = ::meas_cpu, int prep_cpu = ::prep_cpu)
+{
+    std::promise<void> affin_ready_promise;
+    std::shared_future<void> affin_ready_fut(affin_ready_promise.get_future());
+
+    std::thread meas_thr(meas, timed, atop_name, test_type, affin_ready_fut), 
+                prep_thr(prep, affin_ready_fut);
+
+    set_affinity(meas_thr, prep_thr, meas_cpu, prep_cpu);
+
+    affin_ready_promise.set_value();
+
+    meas_thr.join();
+    prep_thr.join();
+}
+
+// MESI_reader_do_meas: Make MESI measurement with measurement,
+//                      preparation and reader threads (O and F states)
+void MESI_reader_do_meas(timed_kernel_t timed, const std::string &atop_name,
+                         MESI_meas_func meas, MESI_prep_func prep)
+{
+    std::promise<void> affin_ready_promise;
+    std::shared_future<void> affin_ready_fut(affin_ready_promise.get_future());
+
+    std::thread meas_thr(meas, timed, atop_name, "MESI", affin_ready_fut), 
+                prep_thr(prep, affin_ready_fut),
+                reader_thr(prep_reader, affin_ready_fut);
+
+    set_affinity(meas_thr, prep_thr, meas_cpu, prep_cpu);
+    set_affinity(reader_thr, reader_cpu);
+
+    affin_ready_promise.set_value();
+
+    meas_thr.join();
+    prep_thr.join();
+    reader_thr.join();
+}
+
+// MESI_M_meas_prep: Make MESI measurement for M (Modified) state
+void MESI_M_do_meas(timed_kernel_t timed, const std::string &atop_name)
+{
+    std::promise<void> affin_ready_promise;
+    std::future<void> affin_ready_fut(affin_ready_promise.get_future());
+
+    std::thread meas_thr(meas_M, timed, atop_name, "MESI", 
+                         std::ref(affin_ready_fut));
+
+    set_affinity(meas_thr, meas_cpu);
+
+    affin_ready_promise.set_value();
+
+    meas_thr.join();
+}
+
+// make_MESI_meas: Experiments for different MESI states
+void make_MESI_meas(timed_kernel_t timed, const std::string &atop_name)
+{
+    MESI_do_meas(timed, atop_name, meas_I, prep_I);
+
+    MESI_do_meas(timed, atop_name, meas_E, prep_E);
+
+    MESI_do_meas(timed, atop_name, meas_S, prep_S);
+
+    MESI_M_do_meas(timed, atop_name);
+
+    if (reader_cpu >= 0) {
+        MESI_reader_do_meas(timed, atop_name, meas_O, prep_O);
+
+        MESI_reader_do_meas(timed, atop_name, meas_F, prep_F);
+    }
+
+    if (remote_socket_cpu >= 0) {
+        MESI_do_meas(timed, atop_name, meas_RM, prep_I, "MESI", 
+                     meas_cpu, remote_socket_cpu);
+    }
+
+    if (remote_l3_cpu >= 0) {
+        MESI_do_meas(timed, atop_name, meas_RL3, prep_I, "MESI", 
+                     meas_cpu, remote_l3_cpu);
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 Core-to-core measurements
+///////////////////////////////////////////////////////////
+
+// c2c_cpus: CPUs for core-to-core matrix (at most cfg.c2c_max CPUs 
+//           evenly sampled from the CPUs of measurement threads)
+std::vector<int> c2c_cpus()
+{
+    const auto ncpus = int(thread_cpus.size());
+
+    if ((cfg.c2c_max <= 0) || (cfg.c2c_max >= ncpus))
+        return thread_cpus;
+
+    std::vector<int> cpus;
+
+    for (auto i = 0; i < cfg.c2c_max; i++)
+        cpus.push_back(thread_cpus[i * ncpus / cfg.c2c_max]);
+
+    return cpus;
+}
+
+// write_c2c_matrix: Write NxN matrix of latencies 
+//                   (row is measurement CPU, column is preparation CPU)
+void write_c2c_matrix(const std::string &fname, const std::vector<int> &cpus,
+                      const std::vector<std::vector<double>> &matrix)
+{
+    auto &ofile = open_data_file(fname);
+
+    ofile << "cpu";
+    for (auto cpu: cpus)
+        ofile << "\t" << cpu;
+    ofile << "\n";
+
+    for (auto i = 0u; i < cpus.size(); i++) {
+        ofile << cpus[i];
+
+        for (auto j = 0u; j < cpus.size(); j++) {
+            if (i == j)
+                ofile << "\t-";
+            else
+                ofile << "\t" << matrix[i][j];
+        }
+
+        ofile << "\n";
+    }
+}
+
+// make_c2c_meas: Core-to-core cache line transfer latencies for all 
+//                ordered pairs of CPUs (I, S and E states handoff)
+void make_c2c_meas(timed_kernel_t timed, const std::string &atop_name)
+{
+    const auto cpus = c2c_cpus();
+    const auto ncpus = cpus.size();
+
+    const std::vector<std::tuple<std::string, MESI_meas_func, 
+                                 MESI_prep_func>> states{
+        {"I", meas_I, prep_I}, {"S", meas_S, prep_S}, {"E", meas_E, prep_E}};
+
+    for (const auto &state: states) {
+        std::vector<std::vector<double>> matrix(ncpus, 
+                                                std::vector<double>(ncpus));
+
+        // Latencies grouped by topology distance
+        std::map<cpu_distance, std::vector<double>> by_dist;
+
+        for (auto i = 0u; i < ncpus; i++) {
+            for (auto j = 0u; j < ncpus; j++) {
+                if (i == j)
+                    continue;
+
+                double time = 0;
+
+                for (auto rep = 0; rep < cfg.nreps; rep++) {
+                    MESI_do_meas(timed, atop_name, std::get<1>(state), 
+                                 std::get<2>(state), "c2c", 
+                                 cpus[i], cpus[j]);
+                    time += take_result(0);
+                }
+
+                matrix[i][j] = time / cfg.nreps;
+                by_dist[cpu_dist(cpus[i], cpus[j])].push_back(matrix[i][j]);
+            }
+        }
+
+        const auto &state_name = std::get<0>(state);
+
+        write_c2c_matrix("data/c2c-" + atop_name + "-" + state_name 
+                         + width_suffix(width.bits, width.order) + ".dat", 
+                         cpus, matrix);
+
+        auto &summary = open_data_file("data/c2c-summary.dat", 
+                                       "op\tstate\tdistance\tpairs\tmean"
+                                       "\tmin\tmax");
+
+        for (const auto &dist: by_dist) {
+            const auto &times = dist.second;
+            const auto minmax = std::minmax_element(times.begin(), 
+                                                    times.end());
+            const auto mean = std::accumulate(times.begin(), times.end(), 
+                                              0.0) / times.size();
+
+            summary << atop_name << width_suffix(width.bits, width.order) 
+                    << "\t" 
+                    << state_name << "\t" 
+                    << cpu_dist_name(dist.first) << "\t" << times.size() 
+                    << "\t" << mean << "\t" << *minmax.first << "\t" 
+                    << *minmax.second << "\n";
+
+            std::cout << atop_name << " " << state_name << " " 
+                      << cpu_dist_name(dist.first) << ": " << mean 
+                      << std::endl;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////
+//                 Array-based measurements
+///////////////////////////////////////////////////////////
+
+// meas_buf: Array-based measurements
+void meas_buf(double (*timed)(int, int), const std::string &atop_name, 
+              int nthr, int ithr, int delay, int stride, 
+              const std::string &test_type)
+{
+    double sumtime = 0;
+    histogram hist;
+    delay_gen dgen(cfg.delay_dist, delay, ithr);
+
+    if (stride == 0)
+        stride = 1;
+
+    // All threads access to one 0th atomic variable
+    if (test_type == "buf_shared") 
+        ithr = 0;
+
+    auto ind = 0;
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = timed(ithr, ind);
+
+        ind = (ind + stride) % atbuf_size;
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+
+        dgen.wait();
+    }
+    
+    if (test_type == "buf_shared") 
+        output(sumtime, hist, atop_name, "A1", nthr, ithr, delay, stride,
+               test_type);
+    else
+        output(sumtime, hist, atop_name, "A2", nthr, ithr, delay, stride,
+               test_type);
+}
+
+// make_buf_meas: Experiments for array-based throughput measurements
+//                For different access patterns
+void make_buf_meas(double (*timed)(int, int), const std::string &atop_name, 
+                    int nthr, int ithr, int delay, int stride)
+{
+    barr.wait(ithr);
+
+    meas_buf(timed, atop_name, nthr, ithr, delay, stride, "buf_shared");
+
+    meas_buf(timed, atop_name, nthr, ithr, delay, stride, "buf_notshared");
+}
+
+// meas_wset: Measure operations on buffer of size_kb KB accessed in order
+//            of wset_seq (pattern) after warm-up pass over the buffer,
+//            rand follows the chase buffer from the element of wset_seq
+void meas_wset(const atop_kernels &atop, int nthr, int ithr, int size_kb, 
+               const std::string &pattern, const std::string &test_type)
+{
+    double sumtime = 0;
+    histogram hist;
+    const auto &seq = wset_seq[ithr];
+    const auto chase = (pattern == "rand");
+
+    // All threads access to the buffer of 0th thread
+    const auto ibuf = (test_type == "wset_shared") ? 0 : ithr;
+
+    if (chase)
+        width.touch_chase(ibuf);
+    else
+        width.touch(ibuf);
+
+    uint32_t ind = seq[0];
+
+    barr.wait(ithr);
+
+    thread_counters.start();
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = chase ? atop.timed_chase(ibuf, ind) 
+                                   : atop.timed_arr(ibuf, seq[i]);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+
+    const auto state = (test_type == "wset_shared") ? "WS" : "WN";
+
+    output(sumtime, hist, atop.name, state, nthr, ibuf, 0, 0, test_type, 
+           1, pattern, size_kb);
+}
+
+// make_wset_meas: Working set measurements on shared and private buffers
+void make_wset_meas(const atop_kernels &atop, int nthr, int ithr, 
+                    int size_kb, const std::string &pattern)
+{
+    meas_wset(atop, nthr, ithr, size_kb, pattern, "wset_shared");
+
+    meas_wset(atop, nthr, ithr, size_kb, pattern, "wset_notshared");
+}
+
+///////////////////////////////////////////////////////////
+//                 False sharing measurements
+///////////////////////////////////////////////////////////
+
+// meas_fshare: Measure latency and throughput of operations of threads
+//              on their own atomic variables located stride bytes apart
+//              (variables are placed by run_fshare_suite())
+void meas_fshare(const atop_kernels &kernels, int nthr, int ithr, 
+                 int stride)
+{
+    double sumtime = 0;
+    histogram hist;
+
+    barr.wait(ithr);
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = kernels.timed(ithr);
+
+        // Restore atomic variable
+        width.reset(ithr);
+
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+
+    const auto elapsed = tput_run(ithr, [&]{ kernels.chunk(ithr); });
+
+    width.reset(ithr);
+
+    const auto ops = tput_ops[ithr].ops;
+
+    // Latency (ns/op) and throughput (Mops/s) of this thread
+    const auto time = sumtime / cfg.nruns;
+    const auto rate = (elapsed > 0) ? ops * 1e3 / elapsed : 0;
+
+    output_result(time, rate, hist, kernels.name, "FS", nthr, 0, stride, 
+                  "fshare");
+}
+
+///////////////////////////////////////////////////////////
+//                 Barrier measurements
+///////////////////////////////////////////////////////////
+
+// meas_fence: Measure pair of operations separated by the fence
+//             (timed is the kernel of the pair and the fence)
+void meas_fence(timed_kernel_t timed, const std::string &atop_names, 
+                const std::string &fence_name, int nthr, int ithr, 
+                const std::string &test_type)
 {
-    affin_ready_fut.wait();
+    double sumtime = 0;
+    histogram hist;
 
-    // Measurement thread index
-    const auto ithr = 0;
+    if (test_type == "fence_shared") {
+        // All threads access to one 0th atomic variable
+        ithr = 0;
+    }
 
-    // Preparation thread index
-    const auto prep_ithr = 1;
+    thread_counters.start();
 
-    for (auto i = 0; i < nruns; i++) {
-        // Wait while meas_S will be ready
-        while (meas_ready == false) {}
+    for (auto i = 0; i < cfg.nruns; i++) {
+        const auto elapsed = timed(ithr);
 
-        // Unset meas flag for reuse
-        meas_ready = false;
+        // Restore atomic variable
+        width.reset(ithr);
 
-        // Read to set E state
-        loaded[prep_ithr].var = atarr[ithr].atvar.load();
+        sumtime += elapsed;
+        hist.record(elapsed);
+    }
+    
+    const auto stride = 0;
+    const auto delay = 0;
 
-        // Signal to meas_E
-        prep_ready.store(true);
+    output(sumtime, hist, atop_names, fence_name, nthr, ithr, delay, stride,
+           test_type);
+}
+
+// make_barr_meas: Experiments for barrier measurements (all fences
+//                 of kernels between the pair of operations)
+void make_barr_meas(const pair_kernels &kernels, int nthr, int ithr)
+{
+    barr.wait(ithr);
+
+    const auto atop_names = kernels.name1 + ", " + kernels.name2;
+
+    for (const auto &fence: kernels.fences) {
+        meas_fence(fence.second, atop_names, fence.first, nthr, ithr, 
+                   "fence_shared");
+
+        meas_fence(fence.second, atop_names, fence.first, nthr, ithr, 
+                   "fence_notshared");
     }
 }
 
 ///////////////////////////////////////////////////////////
-//                 Contention functions
+//                 Barrier skew measurements
 ///////////////////////////////////////////////////////////
 
-// make_cont_meas: Experiments for contention measurements
-//                 Many threads make operations with one atomic variables
-//                 (MESI state is undefined)
-void make_cont_meas(void (*atop)(int), const std::string &atop_name, 
-                    int nthr, int ithr)
+// Timestamps of threads after each barrier release
+std::vector<std::vector<ticks_t>> release_time;
+
+// meas_skew: Measure release skew of the barrier (the time between
+//            the first and the last thread leaving the barrier)
+void meas_skew(int nthr, int ithr)
 {
-    barr.wait();
+    auto &stamps = release_time[ithr];
 
-    const auto delay = 0;
-    meas_simple(atop, atop_name, nthr, ithr, delay, 
-                "contention_shared");
+    for (auto i = 0; i < cfg.nruns; i++) {
+        barr.wait(ithr);
+        stamps[i] = timer_stop();
+    }
 
-    meas_simple(atop, atop_name, nthr, ithr, delay,
-                "contention_notshared");
+    barr.wait(ithr);
+
+    if (ithr != 0)
+        return;
+
+    double sumtime = 0;
+    histogram hist;
+
+    for (auto i = 0; i < cfg.nruns; i++) {
+        auto first = release_time[0][i], last = first;
+
+        for (auto t = 1; t < nthr; t++) {
+            first = std::min(first, release_time[t][i]);
+            last = std::max(last, release_time[t][i]);
+        }
+
+        const auto skew = (last - first) / timer.ticks_per_ns;
+        sumtime += skew;
+        hist.record(skew);
+    }
+
+    // Skew does not depend on operand width (no test variables)
+    const auto avgtime = sumtime / cfg.nruns;
+
+    output_result(avgtime, (avgtime > 0) ? 1e3 / avgtime : 0, hist, 
+                  barrier_type_name(barr.get_type()), "SK", nthr, 0, 0, 
+                  "barrier_skew");
 }
 
 ///////////////////////////////////////////////////////////
-//                 Delay measurement
+//                 Init, output
 ///////////////////////////////////////////////////////////
 
-// make_cont_meas: Experiments for contention measurements
-//                 Many threads make operations with one atomic variables
-//                 (MESI state is undefined)
-void make_delay_meas(void (*atop)(int), const std::string &atop_name, 
-                    int nthr, int ithr, int delay)
+// init_data: Allocate per-thread results for nthr threads
+void init_data(int nthr)
 {
-    barr.wait();
+    results = std::vector<thread_results>(nthr);
+}
 
-    meas_simple(atop, atop_name, nthr, ithr, delay, 
-                "delay_shared");
+// Column names for latency percentiles
+const std::string hist_header = "\tp50\tp99\tp99.9\tmax";
 
-    // meas_simple_notshared(atop, atop_name, nthr, ithr, delay,
-    //                       "delay_notshared");
+// hist_row: Latency percentiles as tab-separated columns
+std::string hist_row(const histogram &hist)
+{
+    std::ostringstream row;
+
+    row << "\t" << hist.percentile(0.5) << "\t" << hist.percentile(0.99)
+        << "\t" << hist.percentile(0.999) << "\t" << hist.maximum();
+
+    return row.str();
+}
+
+// Column names for NUMA node of test variables and the share of 
+// measurements on memory of remote node
+const std::string mem_header = "\tmem_node\tremote";
+
+// mem_row: NUMA node of test variables and share of remote measurements
+std::string mem_row(const avgtime_val &val)
+{
+    std::ostringstream row;
+
+    row << "\t" << val.mem_node << "\t" << double(val.remote) / val.count;
+
+    return row.str();
+}
+
+// counters_row: Counts of events per operation (averaged over threads)
+std::string counters_row(const avgtime_val &val)
+{
+    std::ostringstream row;
+
+    for (auto i = 0u; i < counter_events.size(); i++)
+        row << "\t" << val.counters[i] / val.count;
+
+    return row.str();
 }
 
+// result_record: Structured record of the result with all keys
+record result_record(const avgtime_val &val)
+{
+    record rec;
+
+    const auto nreps = val.count / std::max(val.nthr, 1);
+
+    rec.add("record", "result");
+    rec.add("run", run_id);
+    rec.add("suite", current_suite);
+    rec.add("test", val.test_type);
+    rec.add("op", val.atop_name);
+    rec.add("state", val.MESI_state);
+    rec.add("width", val.width);
+    rec.add("order", memory_order_name(val.order));
+    rec.add("nthr", val.nthr);
+    rec.add("delay", val.delay);
+    rec.add("stride", val.stride);
+    rec.add("batch", val.batch);
+    rec.add("pattern", val.pattern);
+    rec.add("size_kb", val.size_kb);
+    rec.add("samples", val.count);
+    rec.add("time_ns", val.time / val.count);
+    rec.add("rate_mops", val.rate / std::max(1, nreps));
+    rec.add("p50", val.hist.percentile(0.5));
+    rec.add("p99", val.hist.percentile(0.99));
+    rec.add("p99_9", val.hist.percentile(0.999));
+    rec.add("max", val.hist.maximum());
+
+    for (auto i = 0; i < max_stats; i++)
+        rec.add("stat" + std::to_string(i), val.stats[i]);
+
+    rec.add("mem_node", val.mem_node);
+    rec.add("remote", double(val.remote) / val.count);
+
+    for (auto i = 0u; i < counter_events.size(); i++)
+        rec.add(counter_events[i].name, val.counters[i] / val.count);
+
+    return rec;
+}
+
+// output_global: 
+void output_global()
+{
+    std::cout << "=====================================" << std::endl;
+    std::cout << "TOTAL output:" << std::endl;
+    std::cout << "=====================================" << std::endl;
+
+    for (auto &elem: avgtime_sum) {
+        const auto test_type = elem.second.test_type;
+        const auto atop_name = elem.second.atop_name;
+        const auto MESI_state = elem.second.MESI_state;
+        const auto suffix = width_suffix(elem.second.width, 
+                                         elem.second.order);
+        const auto avgtime = elem.second.time / elem.second.count;
+        const auto nthr = elem.second.nthr;
+        const auto delay = elem.second.delay;
+        const auto stride = elem.second.stride;
+        const auto batch = elem.second.batch;
+        const auto nreps = elem.second.count / nthr;
+        const auto rate = elem.second.rate / std::max(1, nreps);
+        const auto hist = hist_row(elem.second.hist);
+        const auto mem = mem_row(elem.second);
+        const auto cnt = counters_row(elem.second);
+
+        sink.write(result_record(elem.second));
+
+        std::cout << "WIDTH " << elem.second.width << " " 
+                  << memory_order_name(elem.second.order)
+                  << " NTHR " << nthr << " " << atop_name << " " 
+                  << MESI_state << " " << avgtime << hist << std::endl;
+
+        if ((test_type == "contention_shared") || 
+            (test_type == "contention_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                     + atop_name + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\ttime" + hist_header 
+                                               + mem_header 
+                                               + counters_header());
+
+            ofile << nthr << "\t" << avgtime << hist << mem << cnt 
+                  << "\n";
+        } else if ((test_type == "delay_shared") ||
+                   (test_type == "delay_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + "-nthr"  
+                                + std::to_string(nthr) + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "delay\ttime" + hist_header
+                                               + counters_header());
+
+            ofile << delay << "\t" << avgtime << hist << cnt << "\n";
+        } else if (test_type == "MESI") {
+
+            std::string fname = "data/" + test_type + "-"
+                                + MESI_state + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname);
+
+            ofile << atop_name << "\t" << avgtime << hist << mem << cnt
+                  << "\n";
+
+        } else if ((test_type == "buf_shared") ||
+                   (test_type == "buf_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + "-nthr"  
+                                + std::to_string(nthr) + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname);
+
+            ofile << stride << "\t" << avgtime << hist << mem << cnt 
+                  << "\n";
+        } else if ((test_type == "wset_shared") ||
+                   (test_type == "wset_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + "-" + elem.second.pattern 
+                                + "-nthr" + std::to_string(nthr) + suffix 
+                                + ".dat";
+
+            auto &ofile = open_data_file(fname, "size_kb\ttime" 
+                                               + hist_header + mem_header
+                                               + counters_header());
+
+            ofile << elem.second.size_kb << "\t" << avgtime << hist << mem << cnt 
+                  << "\n";
+        } else if ((test_type == "fence_shared") ||
+                   (test_type == "fence_notshared")) {
+
+            std::string fname = "data/" + test_type + "-nthr" 
+                                + std::to_string(nthr) + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "op1\top2\tfence\ttime" 
+                                               + hist_header
+                                               + counters_header());
+
+            // Operation pair "op1, op2" is split into two columns
+            const auto ops = split(atop_name, ',');
+
+            ofile << trim(ops[0]) << "\t" << trim(ops[1]) << "\t" 
+                  << MESI_state << "\t" << avgtime << hist << cnt 
+                  << "\n";
+        } else if ((test_type == "batch_shared") ||
+                   (test_type == "batch_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + "-b"
+                                + std::to_string(batch) + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\ttime\tthr_mops\tagg_mops"
+                                               + hist_header
+                                               + counters_header());
+
+            ofile << nthr << "\t" << avgtime << "\t" << rate / nthr
+                  << "\t" << rate << hist << cnt << "\n";
+        } else if ((test_type == "tput_shared") ||
+                   (test_type == "tput_notshared")) {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, 
+                                        "nthr\tagg_mops\tthr_mops\tns_op");
+
+            ofile << nthr << "\t" << rate << "\t" << rate / nthr 
+                  << "\t" << avgtime << "\n";
+        } else if (test_type == "fshare") {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + "-nthr"  
+                                + std::to_string(nthr) + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "stride\ttime\tagg_mops"
+                                               "\tthr_mops" + hist_header);
+
+            ofile << stride << "\t" << avgtime << "\t" << rate << "\t" 
+                  << rate / nthr << hist << "\n";
+        } else if (test_type == "casloop") {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\ttime\tattempts"
+                                               "\tfail_ratio\tspurious"
+                                               "\tmismatch" + hist_header);
+
+            // Attempts and failures per successful operation
+            const auto &stats = elem.second.stats;
+            const auto nsucc = std::max(stats[0], 1.0);
+            const auto nattempts = std::max(stats[1], 1.0);
+
+            ofile << nthr << "\t" << avgtime << "\t" << stats[1] / nsucc
+                  << "\t" << (stats[2] + stats[3]) / nattempts 
+                  << "\t" << stats[2] / nsucc << "\t" << stats[3] / nsucc
+                  << hist << "\n";
+        } else if (test_type == "backoff") {
+
+            std::string fname = "data/" + test_type + "-" + atop_name 
+                                + "-" + MESI_state + suffix + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\tagg_mops\tns_op"
+                                               "\tfairness");
+
+            // Fairness index is averaged over threads and repetitions
+            const auto fairness = elem.second.stats[0] / elem.second.count;
+
+            ofile << nthr << "\t" << rate << "\t" << avgtime << "\t" 
+                  << fairness << "\n";
+        } else if (test_type == "lock") {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\tagg_mops\tacquire"
+                                               "\tfairness" + hist_header);
+
+            const auto fairness = elem.second.stats[0] / elem.second.count;
+
+            ofile << nthr << "\t" << rate << "\t" << avgtime << "\t" 
+                  << fairness << hist << "\n";
+        } else if (test_type == "barrier_skew") {
+
+            std::string fname = "data/" + test_type + "-" 
+                                + atop_name + ".dat";
+
+            auto &ofile = open_data_file(fname, "nthr\tskew" + hist_header);
+
+            ofile << nthr << "\t" << avgtime << hist << "\n";
+        }
+    }
+
+    avgtime_sum.clear();
+}
 
 ///////////////////////////////////////////////////////////
-//                 MESI measurements
+//                 Suites
 ///////////////////////////////////////////////////////////
 
-// MESI_meas_prep: Make MESI measurement for specified state
-//                 by means of measurement and preparation threads
-//                 (only for E, S and I states)
-void MESI_do_meas(void (*atop)(int), const std::string &atop_name,
-                    std::function<void(void (*)(int), 
-                                       const std::string&,
-                                       const std::string&, 
-                                       std::shared_future<void>)> meas,
-                    std::function<void(std::shared_future<void>)> prep)
+// select_ops: Leave only operations enabled in configuration
+std::vector<atop_kernels> select_ops(const std::vector<atop_kernels> &ops)
 {
-    std::promise<void> affin_ready_promise;
-    std::shared_future<void> affin_ready_fut(affin_ready_promise.get_future());
+    std::vector<atop_kernels> res;
+
+    std::copy_if(ops.begin(), ops.end(), std::back_inserter(res),
+                 [](const atop_kernels &op){
+                     return config_has(cfg.ops, op.name);
+                 });
+
+    for (const auto &op: res)
+        name_register(op.name);
+
+    return res;
+}
+
+// select_pairs: Leave only pairs of operations and fences enabled 
+//               in configuration
+std::vector<pair_kernels> select_pairs(const std::vector<pair_kernels> &pairs)
+{
+    std::vector<pair_kernels> res;
+
+    for (const auto &pair: pairs) {
+        if (!config_has(cfg.ops, pair.name1) || 
+            !config_has(cfg.ops, pair.name2))
+            continue;
+
+        pair_kernels sel{pair.name1, pair.name2, {}};
+
+        for (const auto &fence: pair.fences) {
+            if (config_has(cfg.fences, fence.first)) {
+                sel.fences.push_back(fence);
+                name_register(fence.first);
+            }
+        }
+
+        name_register(pair.name1);
+        name_register(pair.name2);
+        name_register(pair.name1 + ", " + pair.name2);
+
+        res.push_back(sel);
+    }
+
+    return res;
+}
+
+// run_threads: Launch nthr measurement threads func(ithr) bound to 
+//              configured CPUs and wait for their completion
+template <typename F>
+void run_threads(int nthr, F func)
+{
+    for (auto rep = 0; rep < cfg.nreps; rep++) {
+        std::vector<std::thread> meas_threads;
+
+        std::promise<void> affin_ready_promise;
+        std::shared_future<void> affin_ready_fut(
+            affin_ready_promise.get_future());
+
+        // Launch measurement threads (counters are opened on the CPU 
+        // of the thread before its measurements)
+        for (auto ithr = 0; ithr < nthr; ithr++) {
+            std::thread thr([=]{
+                affin_ready_fut.wait();
+                thread_counters.open(empty_region);
+
+                results_ithr = ithr;
+                func(ithr);
+            });
+            set_affinity_by_tid(thr, ithr, thread_cpus);
+            meas_threads.emplace_back(std::move(thr));
+        }
+
+        affin_ready_promise.set_value();
+
+        for (auto &thr: meas_threads) {
+            thr.join();
+        }
+
+        reduce_results();
+    }
+}
+
+// run_cont_suite: Contention measurements for different thread number
+void run_cont_suite(const std::vector<atop_kernels> &atops)
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "CONTENTION MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
+
+    for (auto nthr: cfg.nthr) {
+
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
+
+        for (auto &atop_item: atops) {
+            std::cout << atop_item.name << std::endl;
+
+            run_threads(nthr, [=](int ithr) {
+                make_cont_meas(atop_item.timed, atop_item.name, nthr, ithr);
+            });
+        }
+
+        output_global();
+    }
+}
+
+// run_tput_suite: Fixed-duration throughput measurements for different 
+//                 thread number
+void run_tput_suite(const std::vector<atop_kernels> &atops)
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "THROUGHPUT MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
+
+    tput_ops = std::vector<tput_counter>(config_max_nthr(cfg));
+
+    for (auto nthr: cfg.nthr) {
+
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
+
+        for (auto &atop_item: atops) {
+            std::cout << atop_item.name << std::endl;
+
+            run_threads(nthr, [=](int ithr) {
+                make_tput_meas(atop_item.chunk, atop_item.name, nthr, ithr);
+            });
+        }
+
+        output_global();
+    }
+}
+
+// run_casloop_suite: CAS loop statistics for different thread number
+void run_casloop_suite(const std::vector<atop_kernels> &atops)
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "CAS LOOP MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
+
+    // Single read-modify-write operations to compare with
+    std::vector<atop_kernels> rmw_atops;
+
+    std::copy_if(atops.begin(), atops.end(), std::back_inserter(rmw_atops),
+                 [](const atop_kernels &op){
+                     return (op.name == "FAA") || (op.name == "SWAP");
+                 });
+
+    for (auto nthr: cfg.nthr) {
+
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
+
+        run_threads(nthr, [=](int ithr) {
+            make_casloop_meas(rmw_atops, nthr, ithr);
+        });
+
+        output_global();
+    }
+}
+
+// run_backoff_suite: Throughput and fairness of contended operations 
+//                    with backoff policies for different thread number
+void run_backoff_suite()
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "BACKOFF MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-    std::thread meas_thr(meas, atop, atop_name, "MESI", affin_ready_fut), 
-                prep_thr(prep, affin_ready_fut);
+    std::vector<attempt_elem_t> ops;
 
-    set_affinity(meas_thr, prep_thr, meas_cpu, prep_cpu);
+    for (const auto &op: width.attempts) {
+        if (config_has(cfg.ops, op.name)) {
+            ops.push_back(op);
+            name_register(op.name);
+        }
+    }
 
-    affin_ready_promise.set_value();
+    std::vector<backoff_type> types;
 
-    meas_thr.join();
-    prep_thr.join();
-}
+    for (const auto &name: cfg.backoffs) {
+        backoff_type type = backoff_type::none;
+        backoff_type_by_name(name, type);
+        types.push_back(type);
+        name_register(name);
+    }
 
-// MESI_M_meas_prep: Make MESI measurement for M (Modified) state
-void MESI_M_do_meas(void (*atop)(int), const std::string &atop_name)
-{
-    std::promise<void> affin_ready_promise;
-    std::future<void> affin_ready_fut(affin_ready_promise.get_future());
+    tput_ops = std::vector<tput_counter>(config_max_nthr(cfg));
+    backoff_nodes = std::vector<mcs_node>(config_max_nthr(cfg));
 
-    std::thread meas_thr(meas_M, atop, atop_name, "MESI", 
-                         std::ref(affin_ready_fut));
+    for (auto nthr: cfg.nthr) {
 
-    set_affinity(meas_thr, meas_cpu);
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
 
-    affin_ready_promise.set_value();
+        run_threads(nthr, [=](int ithr) {
+            make_backoff_meas(ops, types, nthr, ithr);
+        });
 
-    meas_thr.join();
+        output_global();
+    }
 }
 
-// make_MESI_meas: Experiments for different MESI states
-void make_MESI_meas(void (*atop)(int), const std::string &atop_name)
+// run_lock_suite: Lock implementations for different thread number
+void run_lock_suite()
 {
-    MESI_do_meas(atop, atop_name, meas_I, prep_I);
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "LOCK MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-    MESI_do_meas(atop, atop_name, meas_E, prep_E);
+    tput_ops = std::vector<tput_counter>(config_max_nthr(cfg));
 
-    MESI_do_meas(atop, atop_name, meas_S, prep_S);
+    for (auto nthr: cfg.nthr) {
 
-    MESI_M_do_meas(atop, atop_name);
-}
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
 
-///////////////////////////////////////////////////////////
-//                 Array-based measurements
-///////////////////////////////////////////////////////////
+        for (const auto &name: cfg.locks) {
+            lock_type type = lock_type::tas;
+            lock_type_by_name(name, type);
 
-// meas_buf: Array-based measurements
-void meas_buf(void (*atop)(int, int), const std::string &atop_name, 
-              int nthr, int ithr, int delay, int stride, 
-              const std::string &test_type)
-{
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+            std::cout << name << std::endl;
 
-    if (stride == 0)
-        stride = 1;
+            name_register(name);
+            lck.set_type(type);
+            lck.init(nthr);
 
-    // All threads access to one 0th atomic variable
-    if (test_type == "buf_shared") 
-        ithr = 0;
+            run_threads(nthr, [=](int ithr) {
+                meas_lock(nthr, ithr);
+            });
+        }
 
-    auto ind = 0;
+        output_global();
+    }
+}
+
+// run_delay_suite: Delay measurements for different delays 
+//                  between atomic operations
+void run_delay_suite(const std::vector<atop_kernels> &atops)
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "DELAY MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-    for (auto i = 0; i < nruns; i++) {
-        start = get_time();
-        atop(ithr, ind);
-        end = get_time();
+    for (auto delay: cfg.delays) {
+        for (auto nthr: cfg.delay_nthr) {
 
-        ind = (ind + stride) % atbuf_size;
+            std::cout << "Number of threads: " << nthr << std::endl;
+            barr.init(nthr);
 
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+            for (auto &atop_item: atops) {
+                std::cout << atop_item.name << std::endl;
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
+                run_threads(nthr, [=](int ithr) {
+                    make_delay_meas(atop_item.timed, atop_item.name, nthr, 
+                                    ithr, delay);
+                });
+            }
 
-        // Loop-based delay
-        for (auto j = 0; j < delay; j++);
+            output_global();
+        }
     }
-    
-    if (test_type == "buf_shared") 
-        output(sumtime, atop_name, "A1", nthr, ithr, delay, stride, test_type);
-    else
-        output(sumtime, atop_name, "A2", nthr, ithr, delay, stride, test_type);
 }
 
-// make_buf_meas: Experiments for array-based throughput measurements
-//                For different access patterns
-void make_buf_meas(void (*atop)(int, int), const std::string &atop_name, 
-                    int nthr, int ithr, int delay, int stride)
+// run_MESI_suite: Measurements for different MESI state 
+//                 (number of threads is 1)
+void run_MESI_suite(const std::vector<atop_kernels> &atops)
 {
-    barr.wait();
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "MESI MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-    meas_buf(atop, atop_name, nthr, ithr, delay, stride, "buf_shared");
+    for (auto &atop_item: atops) {
+        std::cout << atop_item.name << std::endl;
 
-    meas_buf(atop, atop_name, nthr, ithr, delay, stride, "buf_notshared");
-}
+        for (auto rep = 0; rep < cfg.nreps; rep++) {
+            make_MESI_meas(atop_item.timed, atop_item.name);
+            reduce_results();
+        }
 
-///////////////////////////////////////////////////////////
-//                 Barrier measurements
-///////////////////////////////////////////////////////////
+        output_global();
+    }
+}
 
-// meas_barr: Measure barrier impact
-void meas_barr(void (*atop1)(int), void (*atop2)(int), 
-               const std::string &atop_names,
-               int nthr, int ithr, const std::string &test_type)
+// run_c2c_suite: Core-to-core latency matrices for all operations
+void run_c2c_suite(const std::vector<atop_kernels> &atops)
 {
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "CORE-TO-CORE MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-    if (test_type == "barr_shared") {
-        // All threads access to one 0th atomic variable
-        ithr = 0;
+    if (c2c_cpus().size() < 2) {
+        std::cerr << "Core-to-core measurements need at least 2 CPUs" 
+                  << std::endl;
+        return;
     }
 
-    for (auto i = 0; i < nruns; i++) {
-        start = get_time();
-        atop1(ithr);
-        asm volatile("mfence" ::: "memory");
-        asm volatile("" ::: "memory");
-        atop2(ithr);
-        end = get_time();
-
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+    for (auto &atop_item: atops) {
+        std::cout << atop_item.name << std::endl;
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
+        make_c2c_meas(atop_item.timed, atop_item.name);
     }
-    
-    const auto stride = 0;
-    const auto delay = 0;
-
-    if (test_type == "barr_shared") 
-       output(sumtime, atop_names, "YBS", nthr, ithr, delay, stride, test_type);
-    else if (test_type == "barr_notshared") 
-       output(sumtime, atop_names, "YBN", nthr, ithr, delay, stride, test_type);
 }
 
-// meas_nobarr: Measure barrier impact
-void meas_nobarr(void (*atop1)(int), void (*atop2)(int), 
-                 const std::string &atop_names,
-                 int nthr, int ithr, const std::string &test_type)
+// run_wset_sweep: Latency of operations on buffers of different sizes 
+//                 (working sets from L1 to DRAM) and access patterns
+void run_wset_sweep(const std::vector<atop_kernels> &atops_arr)
 {
-    decltype(get_time()) start, end;
-    double sumtime = 0;
+    const auto elem_size = width.bits / 8;
 
-    if (test_type == "nobarr_shared") {
-        // All threads access to one 0th atomic variable
-        ithr = 0;
-    }
+    std::cout << "Working set sweep" << std::endl;
 
-    for (auto i = 0; i < nruns; i++) {
-        start = get_time();
-        atop1(ithr);
-        asm volatile("" ::: "memory");
-        atop2(ithr);
-        end = get_time();
+    for (auto nthr: cfg.nthr) {
 
-        // Restore atomic variable
-        atarr[ithr].atvar = atvar_def;
+        std::cout << "Number of threads: " << nthr << std::endl;
 
-        auto elapsed = std::chrono::duration_cast
-             <time_units>(end - start).count();
-        sumtime += elapsed;
-    }
-    
-    const auto stride = 0;
-    const auto delay = 0;
+        for (auto size_kb: cfg.ws_sizes) {
+            const auto count = std::max(size_t(size_kb) * 1024 / elem_size,
+                                        size_t(1));
 
-    if (test_type == "nobarr_shared") 
-       output(sumtime, atop_names, "NBS", nthr, ithr, delay, stride, test_type);
-    else if (test_type == "nobarr_notshared") 
-       output(sumtime, atop_names, "NBN", nthr, ithr, delay, stride, test_type);
-}
+            std::cout << "Working set: " << size_kb << " KB" << std::endl;
 
-// make_barr_meas: Experiments for barrier measurements
-void make_barr_meas(void (*atop1)(int), void (*atop2)(int), 
-                    const std::string &atop_name1, 
-                    const std::string &atop_name2, 
-                    int nthr, int ithr)
-{
-    barr.wait();
+            width.buffer(nthr, count);
+            const auto chase_count = width.chase(nthr, 
+                                                 size_t(size_kb) * 1024);
 
-    const auto atop_names = atop_name1 + ", " + atop_name2;
+            for (const auto &pattern: cfg.ws_patterns) {
+                access_type type = access_type::seq;
+                access_type_by_name(pattern, type);
+                name_register(pattern);
 
-    meas_barr(atop1, atop2, atop_names, nthr, ithr, "barr_shared");
+                wset_seq.assign(nthr, {});
 
-    meas_barr(atop1, atop2, atop_names, nthr, ithr, "barr_notshared");
+                // Chase buffers have larger elements
+                const auto nelem = (type == access_type::rand) ? chase_count 
+                                                                : count;
 
-    meas_nobarr(atop1, atop2, atop_names, nthr, ithr, "nobarr_shared");
+                for (auto i = 0; i < nthr; i++)
+                    wset_seq[i] = access_seq(type, nelem, elem_size, 
+                                             cfg.nruns, i);
 
-    meas_nobarr(atop1, atop2, atop_names, nthr, ithr, "nobarr_notshared");
-}
+                barr.init(nthr);
 
-///////////////////////////////////////////////////////////
-//                 Init, output
-///////////////////////////////////////////////////////////
+                for (auto &atop_item: atops_arr) {
+                    std::cout << atop_item.name << " " << pattern 
+                              << std::endl;
 
-// init_data: Initialize test arrays and buffers
-void init_data()
-{
-    for (auto i = 0; i < nthr_glob; i++) {
-        atarr[i].atvar = atvar_def;
-        exptd[i].var = exptd_def;
-        des[i].var = des_def;
-        loaded[i].var = loaded_def;
-        val[i].var = val_def;
+                    run_threads(nthr, [=](int ithr) {
+                        make_wset_meas(atop_item, nthr, ithr, size_kb, 
+                                       pattern);
+                    });
+                }
 
+                output_global();
+            }
+        }
     }
 
-    for (auto i = 0u; i < atbuf.size(); i++) {
-        std::fill(std::begin(atbuf[i]), std::end(atbuf[i]), atvar_def);
-    }
+    // Restore buffers of stride measurements
+    wset_seq.clear();
+    width.chase(0, 0);
+    width.buffer(config_max_nthr(cfg), atbuf_size);
 }
 
-// output_global: 
-void output_global()
+// run_array_suite: Array-based measurements for different access patterns
+void run_array_suite()
 {
-    std::cout << "=====================================" << std::endl;
-    std::cout << "TOTAL output:" << std::endl;
-    std::cout << "=====================================" << std::endl;
+    const auto atops_arr = select_ops(width.atops);
 
-    for (auto &elem: avgtime_sum) {
-        const auto test_type = elem.second.test_type;
-        const auto atop_name = elem.second.atop_name;
-        const auto MESI_state = elem.second.MESI_state;
-        const auto avgtime = elem.second.time / elem.second.nthr;
-        const auto nthr = elem.second.nthr;
-        const auto delay = elem.second.delay;
-        const auto stride = elem.second.stride;
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "BUFFER (ARRAY) MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-        std::cout << "NTHR " << nthr << " " << atop_name << " " 
-                  << MESI_state << " " << avgtime << std::endl;
+    for (auto nthr: cfg.nthr) {
 
-        if ((test_type == "contention_shared") || 
-            (test_type == "contention_notshared")) {
+        std::cout << "Number of threads: " << nthr << std::endl;
 
-            std::string fname = "data/" + test_type + "-" 
-                                     + atop_name + ".dat";
+        for (auto stride: cfg.strides) {
+
+            barr.init(nthr);
 
-            std::ifstream check_file(fname);
-            std::fstream ofile(fname, std::fstream::out | std::fstream::app);
+            for (auto &atop_item: atops_arr) {
+                std::cout << atop_item.name << std::endl;
 
-            if (!check_file.good()) {
-                ofile << "nthr\ttime\n";
+                run_threads(nthr, [=](int ithr) {
+                    const auto delay = 0;
+                    make_buf_meas(atop_item.timed_arr, atop_item.name, nthr, 
+                                  ithr, delay, stride);
+                });
             }
 
-            ofile << nthr << "\t" << avgtime << std::endl;
+            output_global();
+        }
+    }
 
-            check_file.close();
-            ofile.close();
-        } else if ((test_type == "delay_shared") ||
-                   (test_type == "delay_notshared")) {
+    run_wset_sweep(atops_arr);
+}
 
-            std::string fname = "data/" + test_type + "-" 
-                                + atop_name + "-nthr"  
-                                + std::to_string(nthr) + ".dat";
+// run_fshare_suite: False sharing measurements for different distances
+//                   between variables of threads and thread numbers
+void run_fshare_suite(const std::vector<atop_kernels> &atops)
+{
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "FALSE SHARING MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-            std::ifstream check_file(fname);
-            std::fstream ofile(fname, std::fstream::out | std::fstream::app);
+    const auto max_nthr = config_max_nthr(cfg);
+    const auto size = width.bits / 8;
 
-            if (!check_file.good()) {
-                ofile << "delay\ttime\n";
-            }
+    tput_ops = std::vector<tput_counter>(max_nthr);
 
-            ofile << delay << "\t" << avgtime << std::endl;
+    for (auto stride: cfg.fs_strides) {
+        if (stride % size != 0) {
+            std::cout << "Stride " << stride << " is not multiple of "
+                      << "operand size, skipped" << std::endl;
+            continue;
+        }
 
-            check_file.close();
-            ofile.close();
-        } else if (test_type == "MESI") {
+        std::cout << "Stride: " << stride << " bytes" << std::endl;
 
-            std::string fname = "data/" + test_type + "-"
-                                + MESI_state + ".dat";
+        width.space(max_nthr, stride);
 
-            std::fstream ofile(fname, std::fstream::out | std::fstream::app);
+        for (auto nthr: cfg.nthr) {
 
-            ofile << atop_name << "\t" << avgtime << std::endl;
+            std::cout << "Number of threads: " << nthr << std::endl;
+            barr.init(nthr);
 
-            ofile.close();
+            for (auto &atop_item: atops) {
+                std::cout << atop_item.name << std::endl;
 
-        } else if ((test_type == "buf_shared") ||
-                   (test_type == "buf_notshared")) {
+                run_threads(nthr, [=](int ithr) {
+                    meas_fshare(atop_item, nthr, ithr, stride);
+                });
+            }
 
-            std::string fname = "data/" + test_type + "-" 
-                                + atop_name + "-nthr"  
-                                + std::to_string(nthr) + ".dat";
+            output_global();
+        }
+    }
 
-            std::fstream ofile(fname, std::fstream::out | std::fstream::app);
+    // Restore configured spacing
+    width.space(max_nthr, spacing_bytes(cfg.spacing, size, cfg.huge_pages));
+}
 
-            ofile << stride << "\t" << avgtime << std::endl;
+// run_barrier_suite: Measurements of operation pairs with and 
+//                    without memory barrier
+void run_barrier_suite()
+{
+    const auto atops_barr = select_pairs(width.atops_barr);
 
-            ofile.close();
-        } else if ((test_type == "barr_shared") ||
-                   (test_type == "barr_notshared") ||
-                   (test_type == "nobarr_shared") ||
-                   (test_type == "nobarr_notshared")) {
+    std::cout << "-------------------------------------" << std::endl;
+    std::cout << "BARRIER (RELAXATION) MEASUREMENTS\n";
+    std::cout << "-------------------------------------" << std::endl;
 
-            std::string fname = "data/" + test_type +
-                                "-nthr" + std::to_string(nthr) + ".dat";
+    for (auto nthr: cfg.nthr) {
 
-            std::fstream ofile(fname, std::fstream::out | std::fstream::app);
+        std::cout << "Number of threads: " << nthr << std::endl;
+        barr.init(nthr);
 
-            ofile << atop_name << "\t" << avgtime << std::endl;
+        for (const auto &pair: atops_barr) {
+            std::cout << pair.name1 << " >> " << pair.name2 << std::endl;
 
-            ofile.close();
+            run_threads(nthr, [&](int ithr) {
+                make_barr_meas(pair, nthr, ithr);
+            });
         }
-    }
 
-    avgtime_sum.clear();
+        output_global();
+    }
 }
 
-int main(int argc, const char *argv[])
+// run_batch_suite: Throughput measurements for streams of 
+//                  back-to-back operations
+void run_batch_suite(const std::vector<atop_kernels> &atops)
 {
-    std::cout << "cores: " << std::thread::hardware_concurrency() << std::endl;
-
-    using atop_vec_elem_t = std::pair<std::string, void (*)(int)>;
-    std::vector<atop_vec_elem_t> atops{
-        {"CAS", CAS}, {"unCAS", unCAS}, {"SWAP", SWAP}, 
-        {"FAA", FAA}, {"load", load}, {"store", store}};
-
-    init_data();
-
-#ifdef CONT_MEAS_ENABLE
-    // Contention measurements for different thread number
     std::cout << "-------------------------------------" << std::endl;
-    std::cout << "CONTENTION MEASUREMENTS\n";
+    std::cout << "BATCH MEASUREMENTS\n";
     std::cout << "-------------------------------------" << std::endl;
 
-    for (auto nthr = nthr_min; nthr <= nthr_max; nthr += nthr_step) {
+    for (auto nthr: cfg.nthr) {
 
         std::cout << "Number of threads: " << nthr << std::endl;
         barr.init(nthr);
 
         for (auto &atop_item: atops) {
-            std::string atop_name = atop_item.first;
-            void (*atop)(int) = atop_item.second;
-
-            std::cout << atop_name << std::endl;
-
-            std::vector<std::thread> meas_threads;
-
-            // Launch measurement threads
-            for (auto ithr = 0; ithr < nthr; ithr++) {
-                std::thread thr(make_cont_meas, atop, atop_name, 
-                                nthr, ithr);
-                set_affinity_by_tid(thr, ithr);
-                meas_threads.emplace_back(std::move(thr));
-            }
+            std::cout << atop_item.name << std::endl;
 
-            for (auto &thr: meas_threads) {
-                thr.join();
-            }
+            run_threads(nthr, [=](int ithr) {
+                make_batch_meas(atop_item, nthr, ithr);
+            });
         }
 
         output_global();
     }
-#endif
+}
 
-#ifdef DELAY_MEAS_ENABLE
-    // Delay measurements for different delays between atomic operations
+// run_skew_suite: Release skew of all barrier types
+void run_skew_suite()
+{
     std::cout << "-------------------------------------" << std::endl;
-    std::cout << "DELAY MEASUREMENTS\n";
+    std::cout << "BARRIER SKEW MEASUREMENTS\n";
     std::cout << "-------------------------------------" << std::endl;
-    for (auto delay = delay_min; delay <= delay_max; delay += delay_step) {
-        for (auto nthr: delay_nthr) {
 
-            std::cout << "Number of threads: " << nthr << std::endl;
-            barr.init(nthr);
+    for (auto type: {barrier_type::condvar, barrier_type::central,
+                     barrier_type::tree, barrier_type::dissem}) {
 
-            for (auto &atop_item: atops) {
-                std::string atop_name = atop_item.first;
-                void (*atop)(int) = atop_item.second;
+        std::cout << "Barrier: " << barrier_type_name(type) << std::endl;
 
-                std::cout << atop_name << std::endl;
+        name_register(barrier_type_name(type));
+        barr.set_type(type);
 
-                std::vector<std::thread> meas_threads;
+        for (auto nthr: cfg.nthr) {
 
-                // Launch measurement threads
-                for (auto ithr = 0; ithr < nthr; ithr++) {
-                    std::thread thr(make_delay_meas, atop, atop_name, 
-                                    nthr, ithr, delay);
-                    set_affinity_by_tid(thr, ithr);
-                    meas_threads.emplace_back(std::move(thr));
-                }
+            std::cout << "Number of threads: " << nthr << std::endl;
+            barr.init(nthr);
 
-                for (auto &thr: meas_threads) {
-                    thr.join();
-                }
-            }
+            release_time.assign(nthr, std::vector<ticks_t>(cfg.nruns));
+
+            run_threads(nthr, [=](int ithr) {
+                meas_skew(nthr, ithr);
+            });
 
             output_global();
         }
     }
-#endif
 
-#ifdef MESI_MEAS_ENABLE
-    // Measurements for different MESI state (number of threads is 1)
-    std::cout << "-------------------------------------" << std::endl;
-    std::cout << "MESI MEASUREMENTS\n";
-    std::cout << "-------------------------------------" << std::endl;
+    barr.set_type(cfg.barr_type);
+}
 
-    for (auto &atop_item: atops) {
-        std::string atop_name = atop_item.first;
-        void (*atop)(int) = atop_item.second;
+// init_placement: Choose CPUs of threads according to placement policy
+void init_placement()
+{
+    thread_cpus = placement_cpus(cfg.place, cfg.cpus);
 
-        std::cout << atop_name << std::endl;
+    // Online NUMA nodes (a single node 0 without NUMA support)
+    const auto nodes = sysfs_read_cpus("/sys/devices/system/node/online");
+    const auto max_node = nodes.empty() ? 0 : 
+                          *std::max_element(nodes.begin(), nodes.end());
 
-        make_MESI_meas(atop, atop_name);
+    numa_init(max_node);
 
-        output_global();
+    const auto node_online = nodes.empty() ? (cfg.numa_node == 0) : 
+                             config_has(nodes, cfg.numa_node);
+
+    if ((cfg.numa == numa_policy::node) && !node_online) {
+        std::cerr << "No NUMA node " << cfg.numa_node << ", test variables "
+                  << "are placed by first touch" << std::endl;
+        cfg.numa = numa_policy::first;
     }
-#endif
 
-#ifdef ARRAY_MEAS_ENABLE
-    using atop_arr_vec_elem_t = std::pair<std::string, void (*)(int, int)>;
-    std::vector<atop_arr_vec_elem_t> atops_arr{
-        {"CAS", CAS_arr}, {"unCAS", unCAS_arr}, {"SWAP", SWAP_arr}, 
-        {"FAA", FAA_arr}, {"load", load_arr}, {"store", store_arr}};
+    if (cfg.place == placement::none) {
+        meas_cpu = cfg.meas_cpu;
+        prep_cpu = cfg.prep_cpu;
+    } else if (!placement_pair(cfg.place, cfg.cpus, meas_cpu, prep_cpu)) {
+        std::cerr << "No CPU pair for placement " 
+                  << placement_name(cfg.place) << ", using CPUs " 
+                  << cfg.meas_cpu << " and " << cfg.prep_cpu << std::endl;
+        meas_cpu = cfg.meas_cpu;
+        prep_cpu = cfg.prep_cpu;
+    }
 
-    // Array-based measurements for different access patterns
-    std::cout << "-------------------------------------" << std::endl;
-    std::cout << "BUFFER (ARRAY) MEASUREMENTS\n";
-    std::cout << "-------------------------------------" << std::endl;
+    // Reader is the first CPU different from measurement and preparation
+    reader_cpu = cfg.reader_cpu;
 
-    for (auto nthr = nthr_min; nthr <= nthr_max; nthr += nthr_step) {
+    for (auto cpu: thread_cpus) {
+        if ((reader_cpu < 0) && (cpu != meas_cpu) && (cpu != prep_cpu))
+            reader_cpu = cpu;
+    }
 
-        std::cout << "Number of threads: " << nthr << std::endl;
+    // Preparation CPUs on the other socket and in the other L3
+    for (auto cpu: thread_cpus) {
+        if (!cpu_online(cpu) || !cpu_online(meas_cpu))
+            continue;
 
-        for (auto stride = stride_min; 
-             stride <= stride_max; stride += stride_step) {
+        const auto dist = cpu_dist(meas_cpu, cpu);
 
-            barr.init(nthr);
+        if ((remote_socket_cpu < 0) && (dist == cpu_distance::remote))
+            remote_socket_cpu = cpu;
 
-            for (auto &atop_item: atops_arr) {
-                std::string atop_name = atop_item.first;
-                void (*atop)(int, int) = atop_item.second;
+        if ((remote_l3_cpu < 0) && (dist == cpu_distance::package))
+            remote_l3_cpu = cpu;
+    }
 
-                std::cout << atop_name << std::endl;
+    if (reader_cpu < 0)
+        std::cout << "No reader CPU, O and F states are skipped" << std::endl;
 
-                std::vector<std::thread> meas_threads;
+    if (remote_socket_cpu < 0)
+        std::cout << "No CPU on other socket, RM state is skipped" 
+                  << std::endl;
 
-                // Launch measurement threads
-                for (auto ithr = 0; ithr < nthr; ithr++) {
-                    const auto delay = 0;
-                    std::thread thr(make_buf_meas, atop, atop_name, 
-                                    nthr, ithr, delay, stride);
-                    set_affinity_by_tid(thr, ithr);
-                    meas_threads.emplace_back(std::move(thr));
-                }
+    if (remote_l3_cpu < 0)
+        std::cout << "No CPU in other L3, RL3 state is skipped" << std::endl;
 
-                for (auto &thr: meas_threads) {
-                    thr.join();
-                }
-            }
+    std::ostringstream info;
 
-            output_global();
-        }
+    info << "placement " << placement_name(cfg.place) << " cpus";
+
+    for (auto i = 0u; i < thread_cpus.size(); i++)
+        info << (i == 0 ? " " : ",") << thread_cpus[i];
+
+    info << " meas_cpu " << meas_cpu << " prep_cpu " << prep_cpu
+         << " reader_cpu " << reader_cpu 
+         << " remote_socket_cpu " << remote_socket_cpu
+         << " remote_l3_cpu " << remote_l3_cpu
+         << " delay_dist " << delay_type_name(cfg.delay_dist)
+         << " spacing " << spacing_name(cfg.spacing)
+         << " huge_pages " << cfg.huge_pages
+         << " numa " << numa_policy_name(cfg.numa);
+
+    if (cfg.numa == numa_policy::node)
+        info << " numa_node " << cfg.numa_node;
+
+    if (cpu_online(meas_cpu) && cpu_online(prep_cpu)) {
+        info << " (" << cpu_dist_name(cpu_dist(meas_cpu, prep_cpu)) << ")";
     }
-#endif
 
-#ifdef BARRIER_MEAS_ENABLE
-    std::vector<atop_vec_elem_t> atops_barr_op1{
-        {"CAS", CAS_barr}, {"SWAP", SWAP_barr}, 
-        {"FAA", FAA_barr}, {"store", store_barr}};
+    run_info = info.str();
 
-    std::vector<atop_vec_elem_t> atops_barr_op2{
-        {"CAS", CAS_barr}, {"SWAP", SWAP_barr}, 
-        {"FAA", FAA_barr}, {"load", load_barr}};
+    std::cout << run_info << std::endl;
+}
 
-    std::cout << "-------------------------------------" << std::endl;
-    std::cout << "BARRIER (RELAXATION) MEASUREMENTS\n";
-    std::cout << "-------------------------------------" << std::endl;
+// width_select: Make operand width current (bits must be valid), 
+//               test variables of the previous width are freed
+void width_select(int bits)
+{
+    if (width.free != nullptr)
+        width.free();
 
-    for (auto nthr = nthr_min; nthr <= nthr_max; nthr += nthr_step) {
+    width_ops_by_bits(bits, width);
+    width.init(config_max_nthr(cfg));
 
-        std::cout << "Number of threads: " << nthr << std::endl;
-        barr.init(nthr);
+    std::cout << "=====================================" << std::endl;
+    std::cout << "Operand width: " << bits << " bits" << std::endl;
+}
+
+// order_select: Make memory order of scalar and buffer operations current
+void order_select(std::memory_order order)
+{
+    width.set_order(width, order);
+
+    std::cout << "Memory order: " << memory_order_name(order) << std::endl;
+}
 
-        for (auto &atop_item1: atops_barr_op1) {
-            for (auto &atop_item2: atops_barr_op2) {
+// run_suite: Run suite for current operand width and memory order
+void run_suite(const std::string &suite)
+{
+    const auto atops = select_ops(width.atops);
+
+    if (suite == "cont")
+        run_cont_suite(atops);
+    else if (suite == "tput")
+        run_tput_suite(atops);
+    else if (suite == "casloop")
+        run_casloop_suite(atops);
+    else if (suite == "backoff")
+        run_backoff_suite();
+    else if (suite == "delay")
+        run_delay_suite(atops);
+    else if (suite == "mesi")
+        run_MESI_suite(atops);
+    else if (suite == "array")
+        run_array_suite();
+    else if (suite == "barrier")
+        run_barrier_suite();
+    else if (suite == "batch")
+        run_batch_suite(atops);
+    else if (suite == "c2c")
+        run_c2c_suite(atops);
+    else if (suite == "fshare")
+        run_fshare_suite(atops);
+}
 
-                std::string atop_name1 = atop_item1.first;
-                void (*atop1)(int) = atop_item1.second;
+int main(int argc, char *argv[])
+{
+    if (!config_parse(cfg, argc, argv))
+        return 1;
 
-                std::string atop_name2 = atop_item2.first;
-                void (*atop2)(int) = atop_item2.second;
+    std::cout << "cores: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << build_info() << std::endl;
 
-                std::cout << atop_name1 << " >> " << atop_name2 << std::endl;
+#ifndef __OPTIMIZE__
+    std::cerr << "Warning: unoptimized build, measurements include "
+                 "loop overhead (use 'make release')" << std::endl;
+#endif
 
-                std::vector<std::thread> meas_threads;
+    timer_init(cfg.timer);
+    delay_init();
+    counters_init(cfg.counters, cfg.perf_raw);
+
+    barr.set_type(cfg.barr_type);
+
+    topology_discover();
+    topology_print();
+    init_placement();
+
+    run_id = make_run_id();
+    sink.open(cfg.results, "data/results-" + run_id + "." 
+                           + results_format_name(cfg.results),
+              run_metadata(argc, argv));
+
+    width_check();
+
+    init_data(config_max_nthr(cfg));
+
+    for (const auto &name: {"contention_shared", "contention_notshared",
+                            "delay_shared", "delay_notshared", "MESI",
+                            "buf_shared", "buf_notshared",
+                            "fence_shared", "fence_notshared",
+                            "batch_shared", "batch_notshared",
+                            "barrier_skew", "SK", "c2c",
+                            "tput_shared", "tput_notshared", "TS", "TN",
+                            "casloop", "CAS_loop", "CL", "backoff",
+                            "lock", "LK",
+                            "CS", "CN", "DS", "DN", "M", "E", "S", "I",
+                            "O", "F", "RM", "RL3",
+                            "A1", "A2", "BS", "BN", "fshare", "FS",
+                            "wset_shared", "wset_notshared", "WS", "WN",
+                            "none"}) {
+        name_register(name);
+    }
 
-                // Launch measurement threads
-                for (auto ithr = 0; ithr < nthr; ithr++) {
-                    std::thread thr(make_barr_meas, atop1, atop2, 
-                                    atop_name1, atop_name2,
-                                    nthr, ithr);
-                    set_affinity_by_tid(thr, ithr);
-                    meas_threads.emplace_back(std::move(thr));
-                }
+    for (const auto &suite: cfg.suites) {
+        current_suite = suite;
+
+        // Barrier skew and locks do not depend on operand width
+        if (suite == "skew") {
+            run_skew_suite();
+            sink.flush();
+            continue;
+        } else if (suite == "lock") {
+            run_lock_suite();
+            sink.flush();
+            continue;
+        }
 
-                for (auto &thr: meas_threads) {
-                    thr.join();
-                }
+        // Barrier suite has its own (relaxed) operations
+        const auto orders = (suite == "barrier") ? 
+                            std::vector<std::string>{"seq_cst"} : cfg.orders;
+
+        for (auto bits: cfg.widths) {
+            width_select(bits);
+
+            // 128-bit operations ignore memory order
+            const auto width_orders = (bits == 128) ? 
+                                      std::vector<std::string>{"seq_cst"} : 
+                                      orders;
+
+            for (const auto &order_name: width_orders) {
+                std::memory_order order = std::memory_order_seq_cst;
+                memory_order_by_name(order_name, order);
+                order_select(order);
+
+                run_suite(suite);
             }
         }
 
-        output_global();
+        // Results are written at suite boundaries
+        sink.flush();
     }
-#endif
 
     return 0;
 }
@@ -0,0 +1,201 @@
+//
+// atomic128.h: 128-bit atomic variable (cmpxchg16b), atomic types
+//              of operand widths and memory orders
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <string>
+
+///////////////////////////////////////////////////////////
+//                 128-bit atomic
+///////////////////////////////////////////////////////////
+
+using uint128_t = unsigned __int128;
+
+// std::atomic<unsigned __int128> is implemented in libatomic and is not
+// always lock-free, so 128-bit operations are built on the compare-and-swap
+// builtin which is inlined as lock cmpxchg16b with -mcx16
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+#define ATOMIC128_AVAILABLE
+#endif
+
+// atomic128: Subset of std::atomic interface for 128-bit values.
+//            All operations are full barriers (memory orders are ignored, 
+//            so 128-bit results are measured for seq_cst only). load is 
+//            a CAS (lock cmpxchg16b writes the line, it is not a plain 
+//            read), exchange, fetch_add and store are CAS loops
+class alignas(16) atomic128
+{
+public:
+#ifdef ATOMIC128_AVAILABLE
+    static constexpr bool is_always_lock_free = true;
+#else
+    static constexpr bool is_always_lock_free = false;
+#endif
+
+    atomic128(uint128_t v = 0): val(v) {}
+
+    atomic128(const atomic128 &) = delete;
+    atomic128 &operator=(const atomic128 &) = delete;
+
+    uint128_t operator=(uint128_t v)
+    {
+        store(v);
+        return v;
+    }
+
+    uint128_t load(std::memory_order = std::memory_order_seq_cst)
+    {
+        return cas(0, 0);
+    }
+
+    void store(uint128_t v, std::memory_order = std::memory_order_seq_cst)
+    {
+        exchange(v);
+    }
+
+    uint128_t exchange(uint128_t v,
+                       std::memory_order = std::memory_order_seq_cst)
+    {
+        auto old = val;
+
+        for (;;) {
+            const auto prev = cas(old, v);
+
+            if (prev == old)
+                return old;
+
+            old = prev;
+        }
+    }
+
+    bool compare_exchange_weak(uint128_t &expected, uint128_t desired,
+                               std::memory_order = std::memory_order_seq_cst,
+                               std::memory_order = std::memory_order_seq_cst)
+    {
+        const auto prev = cas(expected, desired);
+
+        if (prev == expected)
+            return true;
+
+        expected = prev;
+        return false;
+    }
+
+    bool compare_exchange_strong(uint128_t &expected, uint128_t desired,
+                                 std::memory_order mo1 =
+                                     std::memory_order_seq_cst,
+                                 std::memory_order mo2 =
+                                     std::memory_order_seq_cst)
+    {
+        return compare_exchange_weak(expected, desired, mo1, mo2);
+    }
+
+    uint128_t fetch_add(uint128_t d,
+                        std::memory_order = std::memory_order_seq_cst)
+    {
+        auto old = val;
+
+        for (;;) {
+            const auto prev = cas(old, old + d);
+
+            if (prev == old)
+                return old;
+
+            old = prev;
+        }
+    }
+
+private:
+    // cas: Compare-and-swap returning the previous value
+    uint128_t cas(uint128_t expected, uint128_t desired)
+    {
+#ifdef ATOMIC128_AVAILABLE
+        return __sync_val_compare_and_swap(&val, expected, desired);
+#else
+        // Not reached: 128-bit width is rejected without cmpxchg16b
+        const auto prev = val;
+        if (prev == expected)
+            val = desired;
+        return prev;
+#endif
+    }
+
+    volatile uint128_t val;
+};
+
+///////////////////////////////////////////////////////////
+//                 Atomic types of operand widths
+///////////////////////////////////////////////////////////
+
+// atomic_type: Atomic variable for operand type T
+template <typename T>
+using atomic_type = std::conditional_t<std::is_same_v<T, uint128_t>,
+                                       atomic128, std::atomic<T>>;
+
+// atomic_lock_free: Check that operations on atomic_type<T> are lock-free
+template <typename T>
+constexpr bool atomic_lock_free()
+{
+    return atomic_type<T>::is_always_lock_free;
+}
+
+///////////////////////////////////////////////////////////
+//                 Memory orders
+///////////////////////////////////////////////////////////
+
+// memory_order_by_name: Parse memory order name (consume is not supported)
+inline bool memory_order_by_name(const std::string &name,
+                                 std::memory_order &order)
+{
+    if (name == "relaxed")
+        order = std::memory_order_relaxed;
+    else if (name == "acquire")
+        order = std::memory_order_acquire;
+    else if (name == "release")
+        order = std::memory_order_release;
+    else if (name == "acq_rel")
+        order = std::memory_order_acq_rel;
+    else if (name == "seq_cst")
+        order = std::memory_order_seq_cst;
+    else
+        return false;
+
+    return true;
+}
+
+// memory_order_name: Name of memory order
+inline std::string memory_order_name(std::memory_order order)
+{
+    switch (order) {
+    case std::memory_order_relaxed: return "relaxed";
+    case std::memory_order_consume: return "consume";
+    case std::memory_order_acquire: return "acquire";
+    case std::memory_order_release: return "release";
+    case std::memory_order_acq_rel: return "acq_rel";
+    case std::memory_order_seq_cst: return "seq_cst";
+    }
+
+    return "";
+}
+
+// load_order_valid: Check that memory order is allowed for load
+constexpr bool load_order_valid(std::memory_order order)
+{
+    return (order != std::memory_order_release) &&
+           (order != std::memory_order_acq_rel);
+}
+
+// store_order_valid: Check that memory order is allowed for store
+constexpr bool store_order_valid(std::memory_order order)
+{
+    return (order == std::memory_order_relaxed) ||
+           (order == std::memory_order_release) ||
+           (order == std::memory_order_seq_cst);
+}
@@ -0,0 +1,567 @@
+//
+// config.h: Runtime configuration (command line and config file)
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include <getopt.h>
+
+#include "timer.h"
+#include "utils.h"
+#include "topology.h"
+#include "atomic128.h"
+#include "locks.h"
+#include "delay.h"
+#include "memory.h"
+#include "access.h"
+#include "counters.h"
+#include "sink.h"
+
+///////////////////////////////////////////////////////////
+//                 Configuration
+///////////////////////////////////////////////////////////
+
+struct config {
+    // Suites to run: cont, tput, casloop, backoff, lock, delay, mesi, 
+    // array (with working set sweep), barrier (with fences), batch, skew,
+    // c2c, fshare
+    std::vector<std::string> suites{"barrier"};
+
+    // Atomic operations to measure (empty means all)
+    std::vector<std::string> ops;
+
+    // Operand widths in bits: 8, 16, 32, 64, 128
+    std::vector<int> widths{32};
+
+    // Memory orders of operations: relaxed, acquire, release, acq_rel, 
+    // seq_cst (contention, delay, MESI, array, batch and c2c suites)
+    std::vector<std::string> orders{"seq_cst"};
+
+    // Number of measurements per thread
+    int nruns = 1'000;
+
+    // Number of repetitions of each experiment
+    int nreps = 1;
+
+    // Thread numbers for contention, array, barrier and batch suites
+    std::vector<int> nthr{4, 8, 12};
+
+    // Duration of throughput measurements (ms)
+    int duration = 1'000;
+
+    // Backoff policies for backoff suite: none, const, exp, prop, mcs
+    std::vector<std::string> backoffs{"none", "const", "exp", "prop", "mcs"};
+
+    // Locks for lock suite: tas, ttas, ticket, mcs, clh, mutex, spin, futex
+    std::vector<std::string> locks{"tas", "ttas", "ticket", "mcs", "clh", 
+                                   "mutex", "spin", "futex"};
+
+    // Length of critical section in lock suite (counter increments)
+    int cs = 10;
+
+    // Thread numbers and mean delays between operations (ns) for delay 
+    // suite
+    std::vector<int> delay_nthr{16, 32, 64};
+    std::vector<int> delays{0, 1000, 2000, 3000};
+
+    // Distribution of delays: constant, uniform, normal, exp
+    delay_type delay_dist = delay_type::constant;
+
+    // Strides for array suite
+    std::vector<int> strides{0, 20, 40, 60, 80, 100};
+
+    // Buffer sizes (KB) and access patterns (seq, stride, rand, zipf) 
+    // of working set sweep in array suite
+    std::vector<int> ws_sizes{4, 16, 64, 256, 1024, 4096, 16384, 65536};
+    std::vector<std::string> ws_patterns{"seq", "stride", "rand", "zipf"};
+
+    // Distances between variables of threads for false sharing suite 
+    // (bytes)
+    std::vector<int> fs_strides{4, 8, 16, 32, 64, 128, 256};
+
+    // Fences between operations in barrier suite: none, compiler, mfence,
+    // lock_add, sfence, lfence, thread_fence, signal_fence (empty means all)
+    std::vector<std::string> fences;
+
+    // Batch sizes for batch suite (subset of batch_sizes)
+    std::vector<int> batches{1, 8, 64, 512};
+
+    // CPUs to bind measurement threads (empty means all)
+    std::vector<int> cpus;
+
+    // CPUs to bind measurement and preparation threads in MESI suite
+    // (used with placement none)
+    int meas_cpu = 0;
+    int prep_cpu = 2;
+
+    // CPU of reader thread for O and F states (-1 means automatic)
+    int reader_cpu = -1;
+
+    // Maximal number of CPUs in core-to-core matrix (0 means all)
+    int c2c_max = 0;
+
+    // Placement policy of threads on allowed CPUs
+    placement place = placement::none;
+
+    // Spacing between test variables of threads: same, line, pair, page
+    spacing_type spacing = spacing_type::page;
+
+    // Back test variables and buffers with huge pages (0 or 1)
+    int huge_pages = 0;
+
+    // NUMA placement of test variables and buffers of threads: first, 
+    // local, node (on numa_node), interleave
+    numa_policy numa = numa_policy::first;
+    int numa_node = 0;
+
+    timer_type timer = timer_type::tsc;
+
+    // Count hardware events (software events without PMU) in contention,
+    // delay, MESI, array and batch suites (0 or 1), raw event code is
+    // counted too if it is not 0 (e.g. HITM snoop responses)
+    int counters = 0;
+    uint64_t perf_raw = 0;
+
+    // Format of structured results file data/results-<run id>.<format>: 
+    // none, csv, jsonl, and whether .dat files are written (0 or 1)
+    results_format results = results_format::jsonl;
+    int dat = 1;
+
+    // Barrier to synchronize measurement threads
+    barrier_type barr_type = barrier_type::central;
+};
+
+inline config cfg;
+
+///////////////////////////////////////////////////////////
+//                 Parsing
+///////////////////////////////////////////////////////////
+
+// trim: Remove leading and trailing whitespaces
+inline std::string trim(const std::string &str)
+{
+    const auto first = str.find_first_not_of(" \t\r\n");
+
+    if (first == std::string::npos)
+        return "";
+
+    const auto last = str.find_last_not_of(" \t\r\n");
+
+    return str.substr(first, last - first + 1);
+}
+
+// parse_int_list: Parse list of integers and ranges "min:max[:step]",
+//                 e.g. "1,2,4:16:4"
+inline bool parse_int_list(const std::string &str, std::vector<int> &list)
+{
+    std::vector<int> res;
+
+    for (const auto &item: split(str, ',')) {
+        const auto range = split(item, ':');
+        int min, max, step = 1;
+
+        if ((range.size() == 1) && parse_int(range[0], min)) {
+            res.push_back(min);
+            continue;
+        }
+
+        if ((range.size() < 2) || (range.size() > 3) ||
+            !parse_int(range[0], min) || !parse_int(range[1], max) ||
+            ((range.size() == 3) && !parse_int(range[2], step)) ||
+            (step <= 0))
+            return false;
+
+        for (auto i = min; i <= max; i += step)
+            res.push_back(i);
+    }
+
+    if (res.empty())
+        return false;
+
+    list = res;
+    return true;
+}
+
+// all_positive: Check that all values of the list are positive
+inline bool all_positive(const std::vector<int> &list)
+{
+    return std::all_of(list.begin(), list.end(), [](int v){return v > 0;});
+}
+
+// all_non_negative: Check that all values of the list are not negative
+inline bool all_non_negative(const std::vector<int> &list)
+{
+    return std::all_of(list.begin(), list.end(), [](int v){return v >= 0;});
+}
+
+// config_has: Check if the list is empty (all) or contains the item
+inline bool config_has(const std::vector<std::string> &list,
+                       const std::string &item)
+{
+    return list.empty() ||
+           (std::find(list.begin(), list.end(), item) != list.end());
+}
+
+// config_has: Check if the list contains the value
+inline bool config_has(const std::vector<int> &list, int val)
+{
+    return std::find(list.begin(), list.end(), val) != list.end();
+}
+
+inline bool config_load(config &conf, const std::string &fname);
+
+// config_set: Set configuration parameter by name
+inline bool config_set(config &conf, const std::string &key,
+                       const std::string &value)
+{
+    if (key == "config")
+        return config_load(conf, value);
+    else if (key == "suites") {
+        const std::vector<std::string> known{"cont", "tput", "casloop", 
+                                             "backoff", "lock", "delay", 
+                                             "mesi", "array", "barrier", 
+                                             "batch", "skew", "c2c", 
+                                             "fshare"};
+        conf.suites = split(value, ',');
+        return std::all_of(conf.suites.begin(), conf.suites.end(), 
+                           [&](const std::string &suite){
+                               return config_has(known, suite);
+                           });
+    }
+    else if (key == "ops") {
+        const std::vector<std::string> known{"CAS", "unCAS", "SWAP", "FAA", 
+                                             "load", "store"};
+        conf.ops = split(value, ',');
+        return std::all_of(conf.ops.begin(), conf.ops.end(), 
+                           [&](const std::string &op){
+                               return config_has(known, op);
+                           });
+    }
+    else if (key == "widths")
+        return parse_int_list(value, conf.widths) && 
+               std::all_of(conf.widths.begin(), conf.widths.end(), [](int w){
+                   return (w == 8) || (w == 16) || (w == 32) || (w == 64) ||
+                          (w == 128);
+               });
+    else if (key == "orders") {
+        conf.orders = split(value, ',');
+        return !conf.orders.empty() &&
+               std::all_of(conf.orders.begin(), conf.orders.end(), 
+                           [](const std::string &name){
+                               std::memory_order order;
+                               return memory_order_by_name(name, order);
+                           });
+    } else if (key == "nruns")
+        return parse_int(value, conf.nruns) && (conf.nruns > 0);
+    else if (key == "duration")
+        return parse_int(value, conf.duration) && (conf.duration > 0);
+    else if (key == "backoffs") {
+        conf.backoffs = split(value, ',');
+        return !conf.backoffs.empty() &&
+               std::all_of(conf.backoffs.begin(), conf.backoffs.end(), 
+                           [](const std::string &name){
+                               backoff_type type;
+                               return backoff_type_by_name(name, type);
+                           });
+    } else if (key == "locks") {
+        conf.locks = split(value, ',');
+        return !conf.locks.empty() &&
+               std::all_of(conf.locks.begin(), conf.locks.end(), 
+                           [](const std::string &name){
+                               lock_type type;
+                               return lock_type_by_name(name, type);
+                           });
+    } else if (key == "cs")
+        return parse_int(value, conf.cs) && (conf.cs >= 0);
+    else if (key == "reps")
+        return parse_int(value, conf.nreps) && (conf.nreps > 0);
+    else if (key == "nthr")
+        return parse_int_list(value, conf.nthr) && all_positive(conf.nthr);
+    else if (key == "delay-nthr")
+        return parse_int_list(value, conf.delay_nthr) && 
+               all_positive(conf.delay_nthr);
+    else if (key == "delays")
+        return parse_int_list(value, conf.delays);
+    else if (key == "delay-dist")
+        return delay_type_by_name(value, conf.delay_dist);
+    else if (key == "strides")
+        return parse_int_list(value, conf.strides) && 
+               all_non_negative(conf.strides);
+    else if (key == "ws-sizes")
+        return parse_int_list(value, conf.ws_sizes) && 
+               all_positive(conf.ws_sizes);
+    else if (key == "ws-patterns") {
+        conf.ws_patterns = split(value, ',');
+        return std::all_of(conf.ws_patterns.begin(), conf.ws_patterns.end(), 
+                           [](const std::string &name){
+                               access_type type;
+                               return access_type_by_name(name, type);
+                           });
+    }
+    else if (key == "fs-strides")
+        return parse_int_list(value, conf.fs_strides) && 
+               all_positive(conf.fs_strides);
+    else if (key == "fences") {
+        const std::vector<std::string> known{"none", "compiler", "mfence", 
+                                             "lock_add", "sfence", "lfence",
+                                             "thread_fence", "signal_fence"};
+        conf.fences = split(value, ',');
+        return std::all_of(conf.fences.begin(), conf.fences.end(), 
+                           [&](const std::string &fence){
+                               return config_has(known, fence);
+                           });
+    }
+    else if (key == "batches") {
+        // Batch kernels are instantiated for batch_sizes only
+        const std::vector<int> known{1, 8, 64, 512};
+        return parse_int_list(value, conf.batches) &&
+               std::all_of(conf.batches.begin(), conf.batches.end(), 
+                           [&](int size){
+                               return config_has(known, size);
+                           });
+    }
+    else if (key == "cpus")
+        return parse_cpu_list(value, conf.cpus);
+    else if (key == "meas-cpu")
+        return parse_int(value, conf.meas_cpu);
+    else if (key == "prep-cpu")
+        return parse_int(value, conf.prep_cpu);
+    else if (key == "reader-cpu")
+        return parse_int(value, conf.reader_cpu);
+    else if (key == "timer")
+        return timer_type_by_name(value, conf.timer);
+    else if (key == "c2c-max")
+        return parse_int(value, conf.c2c_max);
+    else if (key == "placement")
+        return placement_by_name(value, conf.place);
+    else if (key == "spacing")
+        return spacing_by_name(value, conf.spacing);
+    else if (key == "huge-pages")
+        return parse_int(value, conf.huge_pages) && 
+               ((conf.huge_pages == 0) || (conf.huge_pages == 1));
+    else if (key == "numa")
+        return numa_policy_by_name(value, conf.numa);
+    else if (key == "numa-node")
+        return parse_int(value, conf.numa_node) && (conf.numa_node >= 0);
+    else if (key == "counters")
+        return parse_int(value, conf.counters) && 
+               ((conf.counters == 0) || (conf.counters == 1));
+    else if (key == "perf-raw") {
+        char *end = nullptr;
+        conf.perf_raw = std::strtoull(value.c_str(), &end, 0);
+        return !value.empty() && (*end == '\0');
+    } else if (key == "results")
+        return results_format_by_name(value, conf.results);
+    else if (key == "dat")
+        return parse_int(value, conf.dat) && 
+               ((conf.dat == 0) || (conf.dat == 1));
+    else if (key == "barrier-type")
+        return barrier_type_by_name(value, conf.barr_type);
+    else
+        return false;
+
+    return true;
+}
+
+// config_load: Load configuration file with "key = value" lines
+//              (keys are the same as long command line options)
+inline bool config_load(config &conf, const std::string &fname)
+{
+    std::ifstream file(fname);
+
+    if (!file.good()) {
+        std::cerr << "Can't open config file " << fname << std::endl;
+        return false;
+    }
+
+    std::string line;
+    auto nline = 0;
+
+    while (std::getline(file, line)) {
+        nline++;
+
+        line = trim(line.substr(0, line.find('#')));
+
+        if (line.empty())
+            continue;
+
+        const auto eq = line.find('=');
+
+        if ((eq == std::string::npos) ||
+            !config_set(conf, trim(line.substr(0, eq)),
+                        trim(line.substr(eq + 1)))) {
+            std::cerr << fname << ":" << nline << ": invalid line: "
+                      << line << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// config_usage: Print command line options
+inline void config_usage(const char *prog)
+{
+    std::cerr
+        << "Usage: " << prog << " [options]\n"
+        << "  -c, --config FILE      config file with \"option = value\" "
+           "lines\n"
+        << "  -s, --suites LIST      cont,tput,casloop,backoff,lock,delay,"
+           "mesi,\n"
+        << "                         array,barrier,batch,skew,c2c,fshare\n"
+        << "  -o, --ops LIST         CAS,unCAS,SWAP,FAA,load,store\n"
+        << "  -w, --widths LIST      operand widths: 8,16,32,64,128 "
+           "(128 is seq_cst)\n"
+        << "  -m, --orders LIST      memory orders: relaxed,acquire,release,"
+           "acq_rel,seq_cst\n"
+        << "  -n, --nruns N          measurements per thread\n"
+        << "  -r, --reps N           repetitions of each experiment\n"
+        << "  -p, --nthr LIST        thread numbers, e.g. 4:12:4\n"
+        << "  -d, --duration MS      duration of throughput measurements\n"
+        << "      --backoffs LIST    none,const,exp,prop,mcs\n"
+        << "      --locks LIST       tas,ttas,ticket,mcs,clh,mutex,spin,futex\n"
+        << "      --cs N             critical section length (increments)\n"
+        << "      --delay-nthr LIST  thread numbers for delay suite\n"
+        << "      --delays LIST      mean delays for delay suite (ns)\n"
+        << "      --delay-dist DIST  constant,uniform,normal,exp\n"
+        << "      --strides LIST     strides for array suite\n"
+        << "      --ws-sizes LIST    buffer sizes for array suite (KB)\n"
+        << "      --ws-patterns LIST seq,stride,rand,zipf\n"
+        << "      --fs-strides LIST  distances of variables for fshare suite "
+           "(bytes)\n"
+        << "      --fences LIST      fences for barrier suite: none,compiler,"
+           "mfence,\n"
+        << "                         lock_add,sfence,lfence,thread_fence,"
+           "signal_fence\n"
+        << "      --batches LIST     batch sizes for batch suite: "
+           "1,8,64,512\n"
+        << "      --cpus LIST        CPUs for measurement threads, "
+           "e.g. 0-3,8\n"
+        << "  -a, --placement P      none, compact, scatter, smt, l3, socket\n"
+        << "      --spacing S        spacing of variables of threads: same, "
+           "line,\n"
+        << "                         pair (adjacent-line prefetch), page\n"
+        << "      --huge-pages 0|1   huge pages for test variables\n"
+        << "      --numa P           placement of test variables: first, "
+           "local,\n"
+        << "                         node, interleave\n"
+        << "      --numa-node N      node for numa placement node\n"
+        << "      --meas-cpu CPU     measurement thread CPU (MESI)\n"
+        << "      --prep-cpu CPU     preparation thread CPU (MESI)\n"
+        << "      --reader-cpu CPU   reader thread CPU (MESI O and F)\n"
+        << "      --c2c-max N        sample N CPUs for core-to-core matrix\n"
+        << "  -t, --timer NAME       tsc or steady\n"
+        << "      --counters 0|1     count events with perf_event_open\n"
+        << "      --perf-raw CODE    raw event to count, e.g. 0x04d2\n"
+        << "      --results FMT      structured results: none, csv, jsonl\n"
+        << "      --dat 0|1          write gnuplot .dat files\n"
+        << "  -b, --barrier-type T   condvar, central, tree or dissem\n"
+        << "Lists are comma-separated values and ranges min:max[:step]"
+        << std::endl;
+}
+
+// config_parse: Parse command line options
+//               (config file options are overridden by later options)
+inline bool config_parse(config &conf, int argc, char *argv[])
+{
+    static const option long_opts[] = {
+        {"config",     required_argument, nullptr, 'c'},
+        {"suites",     required_argument, nullptr, 's'},
+        {"ops",        required_argument, nullptr, 'o'},
+        {"widths",     required_argument, nullptr, 'w'},
+        {"orders",     required_argument, nullptr, 'm'},
+        {"nruns",      required_argument, nullptr, 'n'},
+        {"reps",       required_argument, nullptr, 'r'},
+        {"nthr",       required_argument, nullptr, 'p'},
+        {"duration",   required_argument, nullptr, 'd'},
+        {"backoffs",   required_argument, nullptr, 0},
+        {"locks",      required_argument, nullptr, 0},
+        {"cs",         required_argument, nullptr, 0},
+        {"delay-nthr", required_argument, nullptr, 0},
+        {"delays",     required_argument, nullptr, 0},
+        {"delay-dist", required_argument, nullptr, 0},
+        {"strides",    required_argument, nullptr, 0},
+        {"ws-sizes",   required_argument, nullptr, 0},
+        {"ws-patterns", required_argument, nullptr, 0},
+        {"fs-strides", required_argument, nullptr, 0},
+        {"fences",     required_argument, nullptr, 0},
+        {"batches",    required_argument, nullptr, 0},
+        {"cpus",       required_argument, nullptr, 0},
+        {"placement",  required_argument, nullptr, 'a'},
+        {"spacing",    required_argument, nullptr, 0},
+        {"huge-pages", required_argument, nullptr, 0},
+        {"numa",       required_argument, nullptr, 0},
+        {"numa-node",  required_argument, nullptr, 0},
+        {"c2c-max",    required_argument, nullptr, 0},
+        {"meas-cpu",   required_argument, nullptr, 0},
+        {"prep-cpu",   required_argument, nullptr, 0},
+        {"reader-cpu", required_argument, nullptr, 0},
+        {"timer",      required_argument, nullptr, 't'},
+        {"counters",   required_argument, nullptr, 0},
+        {"perf-raw",   required_argument, nullptr, 0},
+        {"results",    required_argument, nullptr, 0},
+        {"dat",        required_argument, nullptr, 0},
+        {"barrier-type", required_argument, nullptr, 'b'},
+        {"help",       no_argument,       nullptr, 'h'},
+        {nullptr,      0,                 nullptr, 0}
+    };
+
+    int opt, opt_ind;
+
+    while ((opt = getopt_long(argc, argv, "c:s:o:w:m:n:r:p:d:t:b:a:h",
+                              long_opts, &opt_ind)) != -1) {
+        if ((opt == 'h') || (opt == '?')) {
+            config_usage(argv[0]);
+            return false;
+        }
+
+        // Find long option name for short option
+        auto name = long_opts[opt_ind].name;
+
+        if (opt != 0) {
+            for (auto o = long_opts; o->name != nullptr; o++) {
+                if (o->val == opt)
+                    name = o->name;
+            }
+        }
+
+        if (!config_set(conf, name, optarg)) {
+            std::cerr << "Invalid value for --" << name << ": "
+                      << optarg << std::endl;
+            return false;
+        }
+    }
+
+    if (optind < argc) {
+        config_usage(argv[0]);
+        return false;
+    }
+
+    return true;
+}
+
+// config_max_nthr: Maximal number of threads required by experiments
+//                  (at least 3 for MESI measurement, preparation and
+//                  reader threads)
+inline int config_max_nthr(const config &conf)
+{
+    auto nthr = 3;
+
+    for (auto n: conf.nthr)
+        nthr = std::max(nthr, n);
+
+    for (auto n: conf.delay_nthr)
+        nthr = std::max(nthr, n);
+
+    return nthr;
+}
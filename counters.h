@@ -0,0 +1,320 @@
+//
+// counters.h: Hardware performance counters of measurement threads
+//             (perf_event_open)
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+///////////////////////////////////////////////////////////
+//                 Events
+///////////////////////////////////////////////////////////
+
+// Event of perf_event_open (type and config of perf_event_attr)
+struct counter_event {
+    std::string name;
+    uint32_t type;
+    uint64_t config;
+};
+
+// Maximal number of counted events
+const auto max_counters = 5;
+
+// Counts of events (per operation in results)
+using counter_values = std::array<double, max_counters>;
+
+// Events counted by measurement threads (selected by counters_init(),
+// empty if counters are disabled or not available)
+inline std::vector<counter_event> counter_events;
+
+// cache_event: Config of cache event for cache, operation and result
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+
+// Hardware events (raw HITM event is model-specific and is added if set)
+inline std::vector<counter_event> hw_events()
+{
+    return {{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {"instructions", PERF_TYPE_HARDWARE,
+             PERF_COUNT_HW_INSTRUCTIONS},
+            {"l1d_miss", PERF_TYPE_HW_CACHE,
+             cache_event(PERF_COUNT_HW_CACHE_L1D,
+                         PERF_COUNT_HW_CACHE_OP_READ,
+                         PERF_COUNT_HW_CACHE_RESULT_MISS)},
+            {"llc_miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}};
+}
+
+// Software events (fallback in virtual machines and containers without
+// access to PMU)
+inline std::vector<counter_event> sw_events()
+{
+    return {{"task_clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {"ctx_switches", PERF_TYPE_SOFTWARE,
+             PERF_COUNT_SW_CONTEXT_SWITCHES},
+            {"migrations", PERF_TYPE_SOFTWARE,
+             PERF_COUNT_SW_CPU_MIGRATIONS},
+            {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+}
+
+// event_open: Open counter of the event for calling thread in group
+//             (group is -1 for the leader), returns -1 on error
+inline int event_open(const counter_event &event, int group)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = (group == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+// probe_events: Events of the list which can be counted together
+//               (the first event must be available)
+inline std::vector<counter_event>
+probe_events(const std::vector<counter_event> &events)
+{
+    std::vector<counter_event> avail;
+    std::vector<int> fds;
+
+    for (const auto &event: events) {
+        const auto fd = event_open(event, fds.empty() ? -1 : fds[0]);
+
+        if (fd >= 0) {
+            avail.push_back(event);
+            fds.push_back(fd);
+        } else if (fds.empty()) {
+            break;
+        }
+    }
+
+    for (auto fd: fds)
+        close(fd);
+
+    return avail;
+}
+
+// counters_init: Select events: hardware events (and raw event, e.g.
+//                HITM snoop responses, if raw is not 0) or software
+//                events if PMU is not available
+inline void counters_init(bool enable, uint64_t raw)
+{
+    counter_events.clear();
+
+    if (!enable)
+        return;
+
+    auto events = hw_events();
+
+    if (raw != 0)
+        events.push_back({"raw", PERF_TYPE_RAW, raw});
+
+    counter_events = probe_events(events);
+
+    if (counter_events.empty())
+        counter_events = probe_events(sw_events());
+
+    if (counter_events.empty()) {
+        std::cerr << "perf_event_open() failed, counters are disabled "
+                  << "(check kernel.perf_event_paranoid)" << std::endl;
+        return;
+    }
+
+    std::cout << "counters:";
+
+    for (const auto &event: counter_events)
+        std::cout << " " << event.name;
+
+    std::cout << std::endl;
+}
+
+// counters_header: Column names of counted events (per operation)
+inline std::string counters_header()
+{
+    std::string header;
+
+    for (const auto &event: counter_events)
+        header += "\t" + event.name;
+
+    return header;
+}
+
+///////////////////////////////////////////////////////////
+//                 Counters of a thread
+///////////////////////////////////////////////////////////
+
+// Number of empty counted regions to estimate the overhead of counting
+const auto counters_overhead_runs = 1'000;
+
+// perf_counters: Group of counters of counter_events for the thread
+//                which opens it (counts are scaled if the group was
+//                multiplexed). Events are counted only between resume() 
+//                and pause() around timed regions, the counts of an empty
+//                region (ioctl() returns and the timer) are subtracted
+class perf_counters
+{
+public:
+    perf_counters() = default;
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+
+    ~perf_counters() { close_all(); }
+
+    // open: Open counters of the thread (on its CPU) and estimate the 
+    //       overhead by calling empty(), a timed region without 
+    //       operations (once per thread, before measurements)
+    void open(void (*empty)())
+    {
+        if (!fds.empty() || !open_all())
+            return;
+
+        calibrate(empty);
+    }
+
+    // start: Reset counts of the measurement (if counters are open)
+    void start()
+    {
+        if (fds.empty())
+            return;
+
+        reset();
+        active = true;
+    }
+
+    // resume, pause: Enable and disable counters around timed region
+    //                (only if counters are started)
+    void resume()
+    {
+        if (active)
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void pause()
+    {
+        if (active) {
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            nregions++;
+        }
+    }
+
+    // stop: Counts of timed regions since start without the overhead
+    //       (zeros if counters are not started)
+    counter_values stop()
+    {
+        counter_values values{};
+
+        if (!active)
+            return values;
+
+        active = false;
+        values = read_values();
+
+        for (auto i = 0; i < max_counters; i++)
+            values[i] = std::max(values[i] - overhead[i] * nregions, 0.0);
+
+        return values;
+    }
+
+private:
+    bool open_all()
+    {
+        for (const auto &event: counter_events) {
+            const auto fd = event_open(event, fds.empty() ? -1 : fds[0]);
+
+            if (fd < 0) {
+                close_all();
+                return false;
+            }
+
+            fds.push_back(fd);
+        }
+
+        return !fds.empty();
+    }
+
+    void close_all()
+    {
+        for (auto fd: fds)
+            close(fd);
+
+        fds.clear();
+    }
+
+    void reset()
+    {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        nregions = 0;
+    }
+
+    // read_values: Counts since reset (scaled)
+    counter_values read_values()
+    {
+        counter_values values{};
+
+        // nr, time_enabled, time_running, values
+        std::array<uint64_t, 3 + max_counters> buf{};
+
+        if (read(fds[0], buf.data(), sizeof(buf)) <= 0)
+            return values;
+
+        const auto nr = std::min<uint64_t>(buf[0], fds.size());
+        const auto scale = (buf[2] > 0) ? double(buf[1]) / buf[2] : 0;
+
+        for (uint64_t i = 0; i < nr; i++)
+            values[i] = buf[3 + i] * scale;
+
+        return values;
+    }
+
+    // calibrate: Minimal counts of empty counted region (as the timer 
+    //            overhead)
+    void calibrate(void (*empty)())
+    {
+        overhead.fill(std::numeric_limits<double>::max());
+        active = true;
+
+        for (auto i = 0; i < counters_overhead_runs; i++) {
+            reset();
+            empty();
+
+            const auto values = read_values();
+
+            for (auto j = 0; j < max_counters; j++)
+                overhead[j] = std::min(overhead[j], values[j]);
+        }
+
+        active = false;
+    }
+
+    std::vector<int> fds;
+    bool active = false;
+    uint64_t nregions = 0;
+    counter_values overhead{};
+};
+
+// Counters of current thread
+inline thread_local perf_counters thread_counters;
@@ -0,0 +1,137 @@
+//
+// delay.h: Calibrated delays between operations with random 
+//          inter-arrival times
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstdint>
+
+#include "timer.h"
+#include "utils.h"
+
+///////////////////////////////////////////////////////////
+//                 Delay calibration
+///////////////////////////////////////////////////////////
+
+// Distributions of delays with mean delay d (ns):
+//   constant - d
+//   uniform  - uniform in [0, 2d]
+//   normal   - normal with standard deviation d / 10 (non-negative)
+//   exp      - exponential (Poisson arrivals)
+enum class delay_type { constant, uniform, normal, exp };
+
+// Number of pause instructions to calibrate pause-loop delays
+const auto delay_calib_pauses = 1'000'000;
+
+// Pause instructions per nanosecond (delays without TSC timer)
+inline double delay_pauses_per_ns = 1.0;
+
+// delay_type_by_name: Parse delay distribution name
+inline bool delay_type_by_name(const std::string &name, delay_type &dist)
+{
+    if (name == "constant")
+        dist = delay_type::constant;
+    else if (name == "uniform")
+        dist = delay_type::uniform;
+    else if (name == "normal")
+        dist = delay_type::normal;
+    else if (name == "exp")
+        dist = delay_type::exp;
+    else
+        return false;
+
+    return true;
+}
+
+// delay_type_name: Name of delay distribution
+inline std::string delay_type_name(delay_type dist)
+{
+    switch (dist) {
+    case delay_type::constant: return "constant";
+    case delay_type::uniform:  return "uniform";
+    case delay_type::normal:   return "normal";
+    case delay_type::exp:      return "exp";
+    }
+
+    return "";
+}
+
+// delay_init: Calibrate pause loop against steady_clock
+//             (after timer_init())
+inline void delay_init()
+{
+    const auto start = steady_ticks();
+    cpu_pause(delay_calib_pauses);
+    const auto end = steady_ticks();
+
+    delay_pauses_per_ns = double(delay_calib_pauses) / 
+                          std::max(end - start, ticks_t(1));
+
+    std::cout << "delay: " << (timer.type == timer_type::tsc ? "tsc" : 
+                                                               "pause")
+              << " pause " << 1 / delay_pauses_per_ns << " ns" << std::endl;
+}
+
+// delay_spin: Busy wait for ns nanoseconds, spins on TSC if the timer 
+//             is TSC, otherwise on calibrated number of pauses
+inline void delay_spin(double ns)
+{
+#ifdef TSC_TIMER_AVAILABLE
+    if (timer.type == timer_type::tsc) {
+        const auto end = __rdtsc() + ticks_t(ns * timer.ticks_per_ns);
+
+        while (__rdtsc() < end)
+            cpu_relax();
+
+        return;
+    }
+#endif
+    cpu_pause(uint64_t(ns * delay_pauses_per_ns));
+}
+
+///////////////////////////////////////////////////////////
+//                 Delay generator
+///////////////////////////////////////////////////////////
+
+// delay_gen: Random delays of one thread (each thread has its own 
+//            generator, seeded by thread index for reproducibility)
+class delay_gen
+{
+public:
+    delay_gen(delay_type dist, int mean, int seed):
+        dist(dist), mean(mean), rng(seed) {}
+
+    // next: Next delay (ns)
+    double next()
+    {
+        switch (dist) {
+        case delay_type::uniform:
+            return std::uniform_real_distribution<>(0, 2.0 * mean)(rng);
+        case delay_type::normal:
+            return std::max(0.0, std::normal_distribution<>(
+                                     mean, mean / 10.0)(rng));
+        case delay_type::exp:
+            return std::exponential_distribution<>(1.0 / mean)(rng);
+        default:
+            return mean;
+        }
+    }
+
+    // wait: Make the next delay
+    void wait()
+    {
+        if (mean > 0)
+            delay_spin(next());
+    }
+
+private:
+    delay_type dist;
+    int mean;
+    std::mt19937_64 rng;
+};
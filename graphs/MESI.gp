@@ -40,7 +40,9 @@ set key outside center bottom nobox maxrows 2 box width 3
 plot "data/MESI-M.dat" using 2:xtic(1) ti "M" fs pattern 7 lc rgb "#500472", \
      "data/MESI-E.dat" using 2:xtic(1) ti "E" fs pattern 2 lc rgb "#1b6535", \
      "data/MESI-S.dat" using 2:xtic(1) ti "S" fs pattern 6 lc rgb "#320d3e", \
-     "data/MESI-I.dat" using 2:xtic(1) ti "I" fs pattern 1 lc rgb "#ed3572"
+     "data/MESI-I.dat" using 2:xtic(1) ti "I" fs pattern 1 lc rgb "#ed3572", \
+     "data/MESI-O.dat" using 2:xtic(1) ti "O" fs pattern 4 lc rgb "#2f5f8a", \
+     "data/MESI-F.dat" using 2:xtic(1) ti "F" fs pattern 5 lc rgb "#c77c02"
 
 #plot "CAS.dat" using 2:xtic(1) ti "CAS", \
 #     "unCAS.dat" using 2:xtic(1) ti "unCAS"
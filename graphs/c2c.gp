@@ -0,0 +1,12 @@
+set term pngcairo enhanced font "Times New Roman,24" size 1200,1000
+set xlabel "Preparation CPU" 
+set ylabel "Measurement CPU" 
+set cblabel "Latency [ns]" 
+set output "img/c2c-CAS-I.png"
+
+set datafile missing '-'
+set view map
+set palette rgbformulae 33,13,10
+set yrange [] reverse
+
+plot "data/c2c-CAS-I.dat" matrix rowheaders columnheaders with image notitle
@@ -0,0 +1,34 @@
+#set term pngcairo transparent enhanced font "Times,26" size 1200,800
+set term pngcairo enhanced font "Times New Roman,24" size 1200,800
+#set term pngcairo enhanced font "Cantarell,24" size 1200,800
+#set term pngcairo enhanced font "Liberation Serif,24" size 1200,800
+set xlabel "Number of threads" 
+set ylabel "Throughput [Mops/s]" 
+set output "img/tput_notshared.png"
+set key inside top left width 2 maxrows 3 box
+#set key outside bmargin nobox 
+#set nokey
+
+set xrange [ 1 : * ] noreverse writeback
+
+set border lw 3
+set grid lw 2.5
+set pointsize 3.0
+
+plot "./data/tput_notshared-CAS.dat" using 1:2 \
+     ti "CAS" with lp lw 4 pt 5 lc rgb '#C40D28', \
+     \
+     "./data/tput_notshared-unCAS.dat" using 1:2 \
+     ti "unCAS" with lp dt "_" lw 4 pt 9 lc rgb '#007BCC', \
+     \
+     "./data/tput_notshared-SWAP.dat" using 1:2 \
+     ti "SWAP" with lp dt "_.." lw 4 pt 8 lc rgb '#d9138a', \
+     \
+     "./data/tput_notshared-FAA.dat" using 1:2 \
+     ti "FAA" with lp dt "-_" lw 4 pt 2 lc rgb '#f3ca20', \
+     \
+     "./data/tput_notshared-load.dat" using 1:2 \
+     ti "load" with lp dt "-." lw 4 pt 7 lc rgb '#500472', \
+     \
+     "./data/tput_notshared-store.dat" using 1:2 \
+     ti "store" with lp dt "-" lw 4 pt 4 lc rgb '#ff6e40'
@@ -0,0 +1,107 @@
+//
+// hist.h: Log-bucketed latency histogram
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////
+//                 Histogram
+///////////////////////////////////////////////////////////
+
+// HDR-style histogram: each power-of-two range of values is divided into
+// hist_nsub linear sub-buckets, so the relative error is below 1/hist_nsub.
+// Values are stored in units of 1/hist_scale ns.
+const int hist_sub_bits = 4;
+const int hist_nsub = 1 << hist_sub_bits;
+const int hist_max_exp = 47;
+const int hist_nbuckets = (hist_max_exp - hist_sub_bits + 2) * hist_nsub;
+const double hist_scale = 10.0;
+
+class histogram
+{
+public:
+    // record: Add sample (ns) to histogram, no allocation
+    void record(double time)
+    {
+        const auto val = uint64_t(std::max(time, 0.0) * hist_scale);
+        counts[bucket(val)]++;
+        total++;
+        max = std::max(max, time);
+    }
+
+    // merge: Add all samples of other histogram
+    void merge(const histogram &other)
+    {
+        for (auto i = 0; i < hist_nbuckets; i++)
+            counts[i] += other.counts[i];
+
+        total += other.total;
+        max = std::max(max, other.max);
+    }
+
+    // percentile: Value (ns) below which p (0..1) of samples fall
+    double percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+
+        const auto rank = std::max(uint64_t(1), uint64_t(p * total + 0.5));
+        uint64_t sum = 0;
+
+        for (auto i = 0; i < hist_nbuckets; i++) {
+            sum += counts[i];
+
+            if (sum >= rank) {
+                // Middle of the bucket, but not above the maximum
+                const auto mid = (lower(i) + lower(i + 1)) / 2.0;
+                return std::min(mid / hist_scale, max);
+            }
+        }
+
+        return max;
+    }
+
+    uint64_t count() const { return total; }
+
+    double maximum() const { return max; }
+
+private:
+    // bucket: Bucket index for the value
+    static int bucket(uint64_t val)
+    {
+        if (val < hist_nsub)
+            return int(val);
+
+        const auto exp = 63 - __builtin_clzll(val);
+
+        if (exp > hist_max_exp)
+            return hist_nbuckets - 1;
+
+        const auto shift = exp - hist_sub_bits;
+        const auto sub = int((val >> shift) & (hist_nsub - 1));
+
+        return (shift + 1) * hist_nsub + sub;
+    }
+
+    // lower: Lower bound of the bucket values
+    static uint64_t lower(int ind)
+    {
+        if (ind < hist_nsub)
+            return ind;
+
+        const auto shift = ind / hist_nsub - 1;
+        const auto sub = uint64_t(ind % hist_nsub);
+
+        return (hist_nsub + sub) << shift;
+    }
+
+    std::array<uint64_t, hist_nbuckets> counts{};
+    uint64_t total = 0;
+    double max = 0;
+};
@@ -0,0 +1,459 @@
+//
+// locks.h: Backoff policies and locks built on atomic operations
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "utils.h"
+
+///////////////////////////////////////////////////////////
+//                 Backoff
+///////////////////////////////////////////////////////////
+
+// Backoff policies after a failed (contended) attempt:
+//   none  - retry immediately
+//   const - constant number of pause instructions
+//   exp   - random delay in [1, limit], limit is doubled on each failure
+//   prop  - delay proportional to the number of failures of the operation
+//   mcs   - no failures, operations are serialized by MCS queue lock
+enum class backoff_type { none, constant, exp, prop, mcs };
+
+// Parameters of backoff policies (pause instructions)
+const uint32_t backoff_const = 32;
+const uint32_t backoff_min = 4;
+const uint32_t backoff_max = 4096;
+const uint32_t backoff_prop = 16;
+
+// backoff_type_by_name: Parse backoff policy name
+inline bool backoff_type_by_name(const std::string &name, backoff_type &type)
+{
+    if (name == "none")
+        type = backoff_type::none;
+    else if (name == "const")
+        type = backoff_type::constant;
+    else if (name == "exp")
+        type = backoff_type::exp;
+    else if (name == "prop")
+        type = backoff_type::prop;
+    else if (name == "mcs")
+        type = backoff_type::mcs;
+    else
+        return false;
+
+    return true;
+}
+
+// backoff_type_name: Name of backoff policy
+inline std::string backoff_type_name(backoff_type type)
+{
+    switch (type) {
+    case backoff_type::none:     return "none";
+    case backoff_type::constant: return "const";
+    case backoff_type::exp:      return "exp";
+    case backoff_type::prop:     return "prop";
+    case backoff_type::mcs:      return "mcs";
+    }
+
+    return "";
+}
+
+// backoff: State of backoff policy of one thread
+class backoff
+{
+public:
+    backoff(backoff_type type, uint32_t seed):
+        type(type), rnd(seed * 2654435761u + 1) {}
+
+    // reset: Forget failures after successful attempt
+    void reset()
+    {
+        failures = 0;
+        limit = backoff_min;
+    }
+
+    // fail: Delay after failed attempt
+    void fail()
+    {
+        failures++;
+
+        switch (type) {
+        case backoff_type::constant:
+            cpu_pause(backoff_const);
+            break;
+        case backoff_type::exp:
+            // Random jitter keeps threads from retrying simultaneously
+            cpu_pause(1 + next_rand() % limit);
+            limit = std::min(limit * 2, backoff_max);
+            break;
+        case backoff_type::prop:
+            cpu_pause(std::min(failures * backoff_prop, backoff_max));
+            break;
+        default:
+            break;
+        }
+    }
+
+private:
+    // next_rand: xorshift32 pseudo-random number
+    uint32_t next_rand()
+    {
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 17;
+        rnd ^= rnd << 5;
+        return rnd;
+    }
+
+    backoff_type type;
+    uint32_t rnd;
+    uint32_t failures = 0;
+    uint32_t limit = backoff_min;
+};
+
+///////////////////////////////////////////////////////////
+//                 MCS lock
+///////////////////////////////////////////////////////////
+
+// Queue node of a thread, spinning is local to the node
+struct alignas(64) mcs_node {
+    std::atomic<mcs_node *> next{nullptr};
+    std::atomic<bool> locked{false};
+};
+
+// mcs_lock: Queue lock of Mellor-Crummey and Scott
+class mcs_lock
+{
+public:
+    void lock(mcs_node &node)
+    {
+        node.next.store(nullptr, std::memory_order_relaxed);
+        node.locked.store(true, std::memory_order_relaxed);
+
+        auto prev = tail.exchange(&node, std::memory_order_acq_rel);
+
+        if (prev == nullptr)
+            return;
+
+        prev->next.store(&node, std::memory_order_release);
+
+        while (node.locked.load(std::memory_order_acquire))
+            cpu_relax();
+    }
+
+    void unlock(mcs_node &node)
+    {
+        auto next = node.next.load(std::memory_order_acquire);
+
+        if (next == nullptr) {
+            auto expected = &node;
+
+            if (tail.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed))
+                return;
+
+            // Successor is enqueueing, wait for the link
+            while ((next = node.next.load(std::memory_order_acquire)) ==
+                   nullptr)
+                cpu_relax();
+        }
+
+        next->locked.store(false, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<mcs_node *> tail{nullptr};
+};
+
+///////////////////////////////////////////////////////////
+//                 Spinlocks
+///////////////////////////////////////////////////////////
+
+// tas_lock: Test-and-set lock
+class tas_lock
+{
+public:
+    void lock()
+    {
+        while (flag.exchange(true, std::memory_order_acquire))
+            cpu_relax();
+    }
+
+    void unlock() { flag.store(false, std::memory_order_release); }
+
+private:
+    alignas(64) std::atomic<bool> flag{false};
+};
+
+// ttas_lock: Test-and-test-and-set lock (spins on local cached copy)
+class ttas_lock
+{
+public:
+    void lock()
+    {
+        for (;;) {
+            while (flag.load(std::memory_order_relaxed))
+                cpu_relax();
+
+            if (!flag.exchange(true, std::memory_order_acquire))
+                return;
+        }
+    }
+
+    void unlock() { flag.store(false, std::memory_order_release); }
+
+private:
+    alignas(64) std::atomic<bool> flag{false};
+};
+
+// ticket_lock: FIFO lock, ticket is taken by FAA
+class ticket_lock
+{
+public:
+    void lock()
+    {
+        const auto ticket = next.fetch_add(1, std::memory_order_relaxed);
+
+        while (serving.load(std::memory_order_acquire) != ticket)
+            cpu_relax();
+    }
+
+    void unlock()
+    {
+        // Only the owner changes serving
+        const auto cur = serving.load(std::memory_order_relaxed);
+        serving.store(cur + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> next{0};
+    alignas(64) std::atomic<uint32_t> serving{0};
+};
+
+// Queue node of CLH lock
+struct alignas(64) clh_node {
+    std::atomic<bool> locked{false};
+};
+
+// Nodes of a thread in CLH lock (the node is recycled from predecessor)
+struct alignas(64) clh_thread {
+    clh_node *node = nullptr;
+    clh_node *pred = nullptr;
+};
+
+// clh_lock: Queue lock of Craig, Landin and Hagersten 
+//           (spins on the node of predecessor)
+class clh_lock
+{
+public:
+    // init: Allocate nodes for count threads
+    void init(int count)
+    {
+        nodes = std::vector<clh_node>(count + 1);
+        threads = std::vector<clh_thread>(count);
+
+        for (auto i = 0; i < count; i++)
+            threads[i].node = &nodes[i + 1];
+
+        tail.store(&nodes[0]);
+    }
+
+    void lock(int tid)
+    {
+        auto &thr = threads[tid];
+
+        thr.node->locked.store(true, std::memory_order_relaxed);
+        thr.pred = tail.exchange(thr.node, std::memory_order_acq_rel);
+
+        while (thr.pred->locked.load(std::memory_order_acquire))
+            cpu_relax();
+    }
+
+    void unlock(int tid)
+    {
+        auto &thr = threads[tid];
+
+        thr.node->locked.store(false, std::memory_order_release);
+        thr.node = thr.pred;
+    }
+
+private:
+    alignas(64) std::atomic<clh_node *> tail{nullptr};
+    std::vector<clh_node> nodes;
+    std::vector<clh_thread> threads;
+};
+
+// pthread_spin: pthread spinlock
+class pthread_spin
+{
+public:
+    pthread_spin() { pthread_spin_init(&spin, PTHREAD_PROCESS_PRIVATE); }
+
+    ~pthread_spin() { pthread_spin_destroy(&spin); }
+
+    void lock() { pthread_spin_lock(&spin); }
+
+    void unlock() { pthread_spin_unlock(&spin); }
+
+private:
+    alignas(64) pthread_spinlock_t spin;
+};
+
+// futex_lock: Mutex on futex (0 - unlocked, 1 - locked, 
+//             2 - locked with waiters), after U. Drepper "Futexes are tricky"
+class futex_lock
+{
+public:
+    void lock()
+    {
+        int c = 0;
+
+        if (state.compare_exchange_strong(c, 1, std::memory_order_acquire))
+            return;
+
+        if (c != 2)
+            c = state.exchange(2, std::memory_order_acquire);
+
+        while (c != 0) {
+            futex(FUTEX_WAIT_PRIVATE, 2);
+            c = state.exchange(2, std::memory_order_acquire);
+        }
+    }
+
+    void unlock()
+    {
+        if (state.fetch_sub(1, std::memory_order_release) != 1) {
+            state.store(0, std::memory_order_release);
+            futex(FUTEX_WAKE_PRIVATE, 1);
+        }
+    }
+
+private:
+    void futex(int op, int val)
+    {
+        syscall(SYS_futex, reinterpret_cast<int *>(&state), op, val, 
+                nullptr, nullptr, 0);
+    }
+
+    alignas(64) std::atomic<int> state{0};
+};
+
+///////////////////////////////////////////////////////////
+//                 Lock of selected type
+///////////////////////////////////////////////////////////
+
+// Types of locks
+enum class lock_type { tas, ttas, ticket, mcs, clh, mutex, spin, futex };
+
+// lock_type_by_name: Parse lock type name
+inline bool lock_type_by_name(const std::string &name, lock_type &type)
+{
+    if (name == "tas")
+        type = lock_type::tas;
+    else if (name == "ttas")
+        type = lock_type::ttas;
+    else if (name == "ticket")
+        type = lock_type::ticket;
+    else if (name == "mcs")
+        type = lock_type::mcs;
+    else if (name == "clh")
+        type = lock_type::clh;
+    else if (name == "mutex")
+        type = lock_type::mutex;
+    else if (name == "spin")
+        type = lock_type::spin;
+    else if (name == "futex")
+        type = lock_type::futex;
+    else
+        return false;
+
+    return true;
+}
+
+// lock_type_name: Name of lock type
+inline std::string lock_type_name(lock_type type)
+{
+    switch (type) {
+    case lock_type::tas:    return "tas";
+    case lock_type::ttas:   return "ttas";
+    case lock_type::ticket: return "ticket";
+    case lock_type::mcs:    return "mcs";
+    case lock_type::clh:    return "clh";
+    case lock_type::mutex:  return "mutex";
+    case lock_type::spin:   return "spin";
+    case lock_type::futex:  return "futex";
+    }
+
+    return "";
+}
+
+// test_lock: Lock of selected type for count threads
+class test_lock
+{
+public:
+    void set_type(lock_type t) { type = t; }
+
+    lock_type get_type() const { return type; }
+
+    void init(int count)
+    {
+        mcs_nodes = std::vector<mcs_node>(count);
+        clh.init(count);
+    }
+
+    // acquire: Acquire lock by thread tid (tid is in [0, count))
+    void acquire(int tid)
+    {
+        switch (type) {
+        case lock_type::tas:    tas.lock();                break;
+        case lock_type::ttas:   ttas.lock();               break;
+        case lock_type::ticket: ticket.lock();             break;
+        case lock_type::mcs:    mcs.lock(mcs_nodes[tid]);  break;
+        case lock_type::clh:    clh.lock(tid);             break;
+        case lock_type::mutex:  mutex.lock();              break;
+        case lock_type::spin:   spin.lock();               break;
+        case lock_type::futex:  futex.lock();              break;
+        }
+    }
+
+    // release: Release lock by thread tid
+    void release(int tid)
+    {
+        switch (type) {
+        case lock_type::tas:    tas.unlock();               break;
+        case lock_type::ttas:   ttas.unlock();              break;
+        case lock_type::ticket: ticket.unlock();            break;
+        case lock_type::mcs:    mcs.unlock(mcs_nodes[tid]); break;
+        case lock_type::clh:    clh.unlock(tid);            break;
+        case lock_type::mutex:  mutex.unlock();             break;
+        case lock_type::spin:   spin.unlock();              break;
+        case lock_type::futex:  futex.unlock();             break;
+        }
+    }
+
+private:
+    lock_type type = lock_type::tas;
+
+    tas_lock tas;
+    ttas_lock ttas;
+    ticket_lock ticket;
+    mcs_lock mcs;
+    std::vector<mcs_node> mcs_nodes;
+    clh_lock clh;
+    std::mutex mutex;
+    pthread_spin spin;
+    futex_lock futex;
+};
@@ -0,0 +1,347 @@
+//
+// memory.h: Aligned allocation of test variables with configurable
+//           spacing, huge pages, NUMA placement and pre-faulting
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <utility>
+
+#include <vector>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+///////////////////////////////////////////////////////////
+//                 Spacing
+///////////////////////////////////////////////////////////
+
+const size_t cache_line_size = 64;
+
+// Lines fetched together by the adjacent-line (spatial) prefetcher
+const size_t line_pair_size = 2 * cache_line_size;
+
+const size_t huge_page_size = 2 * 1024 * 1024;
+
+// Spacing between variables of consecutive threads:
+//   same - packed, variables of several threads share a cache line
+//   line - adjacent cache lines
+//   pair - separate pairs of lines of adjacent-line prefetcher
+//   page - separate pages (huge pages if enabled)
+enum class spacing_type { same, line, pair, page };
+
+// spacing_by_name: Parse spacing name
+inline bool spacing_by_name(const std::string &name, spacing_type &spacing)
+{
+    if (name == "same")
+        spacing = spacing_type::same;
+    else if (name == "line")
+        spacing = spacing_type::line;
+    else if (name == "pair")
+        spacing = spacing_type::pair;
+    else if (name == "page")
+        spacing = spacing_type::page;
+    else
+        return false;
+
+    return true;
+}
+
+// spacing_name: Name of spacing
+inline std::string spacing_name(spacing_type spacing)
+{
+    switch (spacing) {
+    case spacing_type::same: return "same";
+    case spacing_type::line: return "line";
+    case spacing_type::pair: return "pair";
+    case spacing_type::page: return "page";
+    }
+
+    return "";
+}
+
+// page_size: Size of base page
+inline size_t page_size()
+{
+    const auto size = sysconf(_SC_PAGESIZE);
+
+    return (size > 0) ? size : 4096;
+}
+
+// align_up: Round size up to multiple of align
+inline size_t align_up(size_t size, size_t align)
+{
+    return (size + align - 1) / align * align;
+}
+
+// spacing_bytes: Distance between variables of size elem_size
+inline size_t spacing_bytes(spacing_type spacing, size_t elem_size,
+                            bool huge)
+{
+    switch (spacing) {
+    case spacing_type::same: return elem_size;
+    case spacing_type::line: return align_up(elem_size, cache_line_size);
+    case spacing_type::pair: return align_up(elem_size, line_pair_size);
+    case spacing_type::page:
+        return align_up(elem_size, huge ? huge_page_size : page_size());
+    }
+
+    return elem_size;
+}
+
+///////////////////////////////////////////////////////////
+//                 NUMA placement
+///////////////////////////////////////////////////////////
+
+// Placement of test variables and buffers of threads on NUMA nodes:
+//   first      - first touch by the main thread (default policy)
+//   local      - node of the CPU of the thread
+//   node       - given node
+//   interleave - pages interleaved over all nodes
+enum class numa_policy { first, local, node, interleave };
+
+// Memory is not bound (placed by first touch)
+const int mem_node_any = -1;
+
+// Pages are interleaved over all nodes
+const int mem_node_all = -2;
+
+// Maximal NUMA node id (set by numa_init())
+inline int numa_max_node = 0;
+
+// Binding is supported by the kernel (cleared on the first failure)
+inline bool numa_available = true;
+
+// numa_policy_by_name: Parse NUMA policy name
+inline bool numa_policy_by_name(const std::string &name, numa_policy &policy)
+{
+    if (name == "first")
+        policy = numa_policy::first;
+    else if (name == "local")
+        policy = numa_policy::local;
+    else if (name == "node")
+        policy = numa_policy::node;
+    else if (name == "interleave")
+        policy = numa_policy::interleave;
+    else
+        return false;
+
+    return true;
+}
+
+// numa_policy_name: Name of NUMA policy
+inline std::string numa_policy_name(numa_policy policy)
+{
+    switch (policy) {
+    case numa_policy::first:      return "first";
+    case numa_policy::local:      return "local";
+    case numa_policy::node:       return "node";
+    case numa_policy::interleave: return "interleave";
+    }
+
+    return "";
+}
+
+// numa_init: Set maximal node id (from CPU topology)
+inline void numa_init(int max_node)
+{
+    numa_max_node = std::max(max_node, 0);
+}
+
+// mem_bind: Bind pages of [ptr, ptr + size) to node (mem_node_all - 
+//           interleave over all nodes), present pages are migrated. 
+//           Without NUMA support memory stays where it is first touched
+inline void mem_bind(void *ptr, size_t size, int node)
+{
+    if ((node == mem_node_any) || !numa_available)
+        return;
+
+    const auto bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(numa_max_node / bits + 1);
+
+    if (node == mem_node_all) {
+        for (auto i = 0; i <= numa_max_node; i++)
+            mask[i / bits] |= 1ul << (i % bits);
+    } else {
+        mask[node / bits] |= 1ul << (node % bits);
+    }
+
+    const auto mode = (node == mem_node_all) ? MPOL_INTERLEAVE : MPOL_BIND;
+
+    // The kernel reads maxnode - 1 bits of the mask
+    if (syscall(SYS_mbind, ptr, size, mode, mask.data(), 
+                mask.size() * bits + 1, MPOL_MF_MOVE) != 0) {
+        std::cerr << "mbind() failed, memory is placed by first touch" 
+                  << std::endl;
+        numa_available = false;
+    }
+}
+
+// mem_node: NUMA node of the page of addr (-1 if unknown)
+inline int mem_node(const void *addr)
+{
+    int node = -1;
+
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, 
+                MPOL_F_NODE | MPOL_F_ADDR) != 0)
+        return -1;
+
+    return node;
+}
+
+///////////////////////////////////////////////////////////
+//                 Allocation
+///////////////////////////////////////////////////////////
+
+// mem_alloc: Allocate page-aligned memory, backed by huge pages if huge
+//            (transparent huge pages if hugetlbfs pages are not reserved).
+//            All pages are touched (after binding to node), so page 
+//            faults do not occur in measurements. Returns size of 
+//            mapping in size
+inline void *mem_alloc(size_t &size, bool huge, int node = mem_node_any)
+{
+    size = align_up(size, huge ? huge_page_size : page_size());
+
+    void *ptr = MAP_FAILED;
+
+    if (huge) {
+        ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+
+    if (ptr == MAP_FAILED) {
+        ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (ptr == MAP_FAILED) {
+            std::cerr << "Can't allocate " << size << " bytes" << std::endl;
+            exit(1);
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (huge)
+            madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    mem_bind(ptr, size, node);
+
+    // Pre-fault all pages
+    std::memset(ptr, 0, size);
+
+    return ptr;
+}
+
+// mem_free: Free memory of mem_alloc()
+inline void mem_free(void *ptr, size_t size)
+{
+    if (ptr != nullptr)
+        munmap(ptr, size);
+}
+
+///////////////////////////////////////////////////////////
+//                 Spaced array
+///////////////////////////////////////////////////////////
+
+// spaced_array: count objects of type T located spacing bytes apart
+//               in one page-aligned allocation
+template <typename T>
+class spaced_array
+{
+public:
+    spaced_array() = default;
+
+    spaced_array(const spaced_array &) = delete;
+    spaced_array &operator=(const spaced_array &) = delete;
+
+    spaced_array(spaced_array &&other) noexcept { swap(other); }
+
+    spaced_array &operator=(spaced_array &&other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~spaced_array() { free(); }
+
+    // init: Allocate and construct count objects spacing bytes apart
+    //       (spacing is at least sizeof(T) and multiple of alignof(T)),
+    //       memory is bound to node
+    void init(size_t count, size_t spacing, bool huge, 
+              int node = mem_node_any)
+    {
+        free();
+
+        if (count == 0)
+            return;
+
+        stride = align_up(std::max(spacing, sizeof(T)), alignof(T));
+        nelem = count;
+        bytes = stride * count;
+
+        page = huge ? huge_page_size : page_size();
+        base = static_cast<char *>(mem_alloc(bytes, huge, node));
+
+        for (size_t i = 0; i < nelem; i++)
+            new (base + i * stride) T();
+    }
+
+    // place: Move pages of i-th object to nodes[i] (objects sharing
+    //        a page are placed on the node of the last of them)
+    void place(const std::vector<int> &nodes)
+    {
+        for (size_t i = 0; (i < nelem) && (i < nodes.size()); i++) {
+            const auto first = i * stride / page * page;
+            const auto last = align_up((i + 1) * stride, page);
+
+            mem_bind(base + first, last - first, nodes[i]);
+        }
+    }
+
+    void free()
+    {
+        for (size_t i = 0; i < nelem; i++)
+            (*this)[i].~T();
+
+        mem_free(base, bytes);
+
+        base = nullptr;
+        nelem = 0;
+        bytes = 0;
+    }
+
+    // operator[]: i-th object (the address is computed at runtime, so 
+    //             kernels resolve references before timed regions)
+    T &operator[](size_t i)
+    {
+        return *reinterpret_cast<T *>(base + i * stride);
+    }
+
+    size_t size() const { return nelem; }
+
+private:
+    void swap(spaced_array &other)
+    {
+        std::swap(base, other.base);
+        std::swap(stride, other.stride);
+        std::swap(nelem, other.nelem);
+        std::swap(bytes, other.bytes);
+        std::swap(page, other.page);
+    }
+
+    char *base = nullptr;
+    size_t stride = 0;
+    size_t nelem = 0;
+    size_t bytes = 0;
+    size_t page = 0;
+};
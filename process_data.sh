@@ -1,6 +1,8 @@
 #!/bin/sh
 
-for file in `ls data`; do
+# Sort gnuplot data files (structured results are left as written, c2c 
+# matrices keep the order of their header line and rows)
+for file in `cd data && ls *.dat | grep -v '^c2c-'`; do
     echo $file
     cat data/$file | sort -n >data/$file.tmp
     mv data/$file.tmp data/$file
@@ -1,2 +1,2 @@
 rm -f data/*.dat
-./at
+./at "$@"
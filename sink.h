@@ -0,0 +1,303 @@
+//
+// sink.h: Buffered writer of results: structured records (CSV or JSON
+//         Lines) with run metadata and gnuplot data files
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <type_traits>
+#include <cstdio>
+
+///////////////////////////////////////////////////////////
+//                 Records
+///////////////////////////////////////////////////////////
+
+// Formats of structured results:
+//   none  - only .dat files
+//   csv   - comma-separated values, metadata in "# key: value" lines
+//   jsonl - JSON object per line, the first object is run metadata
+enum class results_format { none, csv, jsonl };
+
+// results_format_by_name: Parse results format name
+inline bool results_format_by_name(const std::string &name,
+                                   results_format &format)
+{
+    if (name == "none")
+        format = results_format::none;
+    else if (name == "csv")
+        format = results_format::csv;
+    else if (name == "jsonl")
+        format = results_format::jsonl;
+    else
+        return false;
+
+    return true;
+}
+
+// results_format_name: Name (and file extension) of results format
+inline std::string results_format_name(results_format format)
+{
+    switch (format) {
+    case results_format::none:  return "none";
+    case results_format::csv:   return "csv";
+    case results_format::jsonl: return "jsonl";
+    }
+
+    return "";
+}
+
+// json_string: Quoted and escaped JSON string
+inline std::string json_string(const std::string &str)
+{
+    std::string res = "\"";
+
+    for (auto c: str) {
+        switch (c) {
+        case '"':  res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n";  break;
+        case '\t': res += "\\t";  break;
+        case '\r': res += "\\r";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                res += buf;
+            } else {
+                res += c;
+            }
+        }
+    }
+
+    return res + "\"";
+}
+
+// csv_string: CSV field, quoted if it contains separators or quotes
+inline std::string csv_string(const std::string &str)
+{
+    if (str.find_first_of(",\"\n") == std::string::npos)
+        return str;
+
+    std::string res = "\"";
+
+    for (auto c: str) {
+        if (c == '"')
+            res += '"';
+        res += c;
+    }
+
+    return res + "\"";
+}
+
+// record: Named fields of one result (or of run metadata) in order
+//         of addition
+class record
+{
+public:
+    void add(const std::string &name, const std::string &val)
+    {
+        fields.push_back({name, val, true});
+    }
+
+    void add(const std::string &name, const char *val)
+    {
+        add(name, std::string(val));
+    }
+
+    template <typename T, 
+              typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    void add(const std::string &name, T val)
+    {
+        std::ostringstream str;
+        str << val;
+        fields.push_back({name, str.str(), false});
+    }
+
+    // json: Record as JSON object
+    std::string json() const
+    {
+        std::string res = "{";
+
+        for (auto i = 0u; i < fields.size(); i++) {
+            const auto &f = fields[i];
+
+            res += (i == 0 ? "" : ", ") + json_string(f.name) + ": " +
+                   (f.quoted ? json_string(f.val) : json_number(f.val));
+        }
+
+        return res + "}";
+    }
+
+    // csv_header, csv: Field names and values as CSV lines
+    std::string csv_header() const
+    {
+        std::string res;
+
+        for (auto i = 0u; i < fields.size(); i++)
+            res += (i == 0 ? "" : ",") + csv_string(fields[i].name);
+
+        return res;
+    }
+
+    std::string csv() const
+    {
+        std::string res;
+
+        for (auto i = 0u; i < fields.size(); i++)
+            res += (i == 0 ? "" : ",") + csv_string(fields[i].val);
+
+        return res;
+    }
+
+    // comments: Fields as "# name: value" lines
+    std::string comments() const
+    {
+        std::string res;
+
+        for (const auto &f: fields)
+            res += "# " + f.name + ": " + f.val + "\n";
+
+        return res;
+    }
+
+private:
+    // json_number: Number as JSON value (inf and nan are not allowed)
+    static std::string json_number(const std::string &val)
+    {
+        if ((val.find("inf") != std::string::npos) ||
+            (val.find("nan") != std::string::npos))
+            return "null";
+
+        return val;
+    }
+
+    struct field {
+        std::string name;
+        std::string val;
+        bool quoted;
+    };
+
+    std::vector<field> fields;
+};
+
+///////////////////////////////////////////////////////////
+//                 Sink
+///////////////////////////////////////////////////////////
+
+// Maximal number of open .dat files (all are closed on overflow)
+const auto max_dat_files = 256;
+
+// result_sink: Append-only writer of result records and .dat files.
+//              Records are buffered and .dat files are kept open until
+//              flush() (called at suite boundaries)
+class result_sink
+{
+public:
+    // open: Start results file in format, metadata is written first
+    bool open(results_format fmt, const std::string &fname,
+              const record &meta)
+    {
+        format = fmt;
+
+        if (format == results_format::none)
+            return true;
+
+        file.open(fname, std::ofstream::app);
+
+        if (!file.good()) {
+            std::cerr << "Can't open results file " << fname << std::endl;
+            format = results_format::none;
+            return false;
+        }
+
+        if (format == results_format::jsonl)
+            file << meta.json() << "\n";
+        else
+            file << meta.comments();
+
+        file.flush();
+
+        return true;
+    }
+
+    // write: Add result record (CSV header is written before the first)
+    void write(const record &rec)
+    {
+        if (format == results_format::jsonl) {
+            buf << rec.json() << "\n";
+        } else if (format == results_format::csv) {
+            if (!csv_header_done) {
+                buf << rec.csv_header() << "\n";
+                csv_header_done = true;
+            }
+
+            buf << rec.csv() << "\n";
+        }
+    }
+
+    // dat: Stream of .dat file for appending, a new file starts with
+    //      comment lines and the header line (if any)
+    std::ostream &dat(const std::string &fname,
+                      const std::vector<std::string> &comments,
+                      const std::string &header = "")
+    {
+        auto it = dat_files.find(fname);
+
+        if (it != dat_files.end())
+            return it->second;
+
+        if (dat_files.size() >= max_dat_files)
+            close_dat();
+
+        std::ifstream check_file(fname);
+        const auto exists = check_file.good();
+        check_file.close();
+
+        auto &ofile = dat_files[fname];
+        ofile.open(fname, std::ofstream::app);
+
+        if (!exists) {
+            for (const auto &line: comments)
+                ofile << "# " << line << "\n";
+
+            if (!header.empty())
+                ofile << header << "\n";
+        }
+
+        return ofile;
+    }
+
+    // flush: Write buffered records and close .dat files
+    void flush()
+    {
+        if (format != results_format::none) {
+            file << buf.str();
+            file.flush();
+        }
+
+        buf.str("");
+        close_dat();
+    }
+
+private:
+    void close_dat()
+    {
+        dat_files.clear();
+    }
+
+    results_format format = results_format::none;
+    std::ofstream file;
+    std::ostringstream buf;
+    bool csv_header_done = false;
+    std::map<std::string, std::ofstream> dat_files;
+};
+
+inline result_sink sink;
@@ -0,0 +1,209 @@
+//
+// timer.h: Timers for measurement loops (TSC and steady_clock backends)
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define TSC_TIMER_AVAILABLE
+#endif
+
+///////////////////////////////////////////////////////////
+//                 Timer state
+///////////////////////////////////////////////////////////
+
+enum class timer_type { steady, tsc };
+
+using ticks_t = uint64_t;
+
+struct timer_state {
+    timer_type type = timer_type::steady;
+
+    // Timer frequency (ticks per nanosecond)
+    double ticks_per_ns = 1.0;
+
+    // Cost of an empty timer_start() / timer_stop() pair (ticks)
+    ticks_t overhead = 0;
+};
+
+inline timer_state timer;
+
+// Number of empty timer pairs to estimate the timer overhead
+const auto timer_overhead_runs = 10'000;
+
+// Duration of TSC calibration against steady_clock
+const auto timer_calib_time = std::chrono::milliseconds(100);
+
+///////////////////////////////////////////////////////////
+//                 Timestamps
+///////////////////////////////////////////////////////////
+
+// timer_mark_begin, timer_mark_end: Compiler barriers marking bounds of 
+//                                   timed regions in generated assembly 
+//                                   (see asm.sh)
+inline void timer_mark_begin()
+{
+    asm volatile("# timed region begin" ::: "memory");
+}
+
+inline void timer_mark_end()
+{
+    asm volatile("# timed region end" ::: "memory");
+}
+
+// steady_ticks: steady_clock timestamp in nanoseconds
+inline ticks_t steady_ticks()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// timer_start: Timestamp at the beginning of the timed region.
+//              lfence before rdtsc waits for the preceding instructions,
+//              lfence after it keeps the timed code from starting early,
+//              the compiler does not move memory accesses across it
+inline ticks_t timer_start()
+{
+#ifdef TSC_TIMER_AVAILABLE
+    if (timer.type == timer_type::tsc) {
+        _mm_lfence();
+        const ticks_t t = __rdtsc();
+        _mm_lfence();
+        timer_mark_begin();
+        return t;
+    }
+#endif
+    const auto t = steady_ticks();
+    timer_mark_begin();
+    return t;
+}
+
+// timer_stop: Timestamp at the end of the timed region.
+//             rdtscp waits for the timed code to complete, lfence keeps
+//             the following instructions from starting before rdtscp
+inline ticks_t timer_stop()
+{
+    timer_mark_end();
+
+#ifdef TSC_TIMER_AVAILABLE
+    if (timer.type == timer_type::tsc) {
+        unsigned aux;
+        const ticks_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+    }
+#endif
+    return steady_ticks();
+}
+
+// timer_elapsed: Elapsed time in nanoseconds without timer overhead
+inline double timer_elapsed(ticks_t start, ticks_t end)
+{
+    auto ticks = end - start;
+    ticks = (ticks > timer.overhead) ? ticks - timer.overhead : 0;
+
+    return ticks / timer.ticks_per_ns;
+}
+
+///////////////////////////////////////////////////////////
+//                 Calibration
+///////////////////////////////////////////////////////////
+
+// tsc_supported: Check rdtscp and invariant TSC support
+inline bool tsc_supported()
+{
+#ifdef TSC_TIMER_AVAILABLE
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    const bool rdtscp = edx & (1u << 27);
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    const bool invariant = edx & (1u << 8);
+
+    return rdtscp && invariant;
+#else
+    return false;
+#endif
+}
+
+// timer_calibrate_freq: Measure TSC frequency against steady_clock
+inline double timer_calibrate_freq()
+{
+    const auto ns_start = steady_ticks();
+    const auto tsc_start = timer_start();
+
+    while (steady_ticks() - ns_start <
+           ticks_t(std::chrono::nanoseconds(timer_calib_time).count())) {}
+
+    const auto tsc_end = timer_stop();
+    const auto ns_end = steady_ticks();
+
+    return double(tsc_end - tsc_start) / (ns_end - ns_start);
+}
+
+// timer_calibrate_overhead: Minimal cost of an empty timer pair
+inline ticks_t timer_calibrate_overhead()
+{
+    auto overhead = ~ticks_t(0);
+
+    for (auto i = 0; i < timer_overhead_runs; i++) {
+        const auto start = timer_start();
+        const auto end = timer_stop();
+        overhead = std::min(overhead, end - start);
+    }
+
+    return overhead;
+}
+
+// timer_init: Select timer backend and calibrate it
+inline void timer_init(timer_type type)
+{
+    if ((type == timer_type::tsc) && !tsc_supported()) {
+        std::cerr << "TSC timer is not supported, using steady_clock"
+                  << std::endl;
+        type = timer_type::steady;
+    }
+
+    timer.type = type;
+    timer.overhead = 0;
+
+    if (type == timer_type::tsc)
+        timer.ticks_per_ns = timer_calibrate_freq();
+    else
+        timer.ticks_per_ns = 1.0;
+
+    timer.overhead = timer_calibrate_overhead();
+
+    std::cout << "timer: " << (type == timer_type::tsc ? "tsc" : "steady")
+              << " freq " << timer.ticks_per_ns << " GHz"
+              << " overhead " << timer.overhead << " ticks ("
+              << timer.overhead / timer.ticks_per_ns << " ns)" << std::endl;
+}
+
+// timer_type_by_name: Parse timer backend name
+inline bool timer_type_by_name(const std::string &name, timer_type &type)
+{
+    if (name == "tsc")
+        type = timer_type::tsc;
+    else if (name == "steady")
+        type = timer_type::steady;
+    else
+        return false;
+
+    return true;
+}
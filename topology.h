@@ -0,0 +1,378 @@
+//
+// topology.h: CPU topology discovery and thread placement policies
+//
+// (C) 2020 Alexey Paznikov <apaznikov@gmail.com>
+//
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+
+#include <dirent.h>
+
+#include "utils.h"
+
+///////////////////////////////////////////////////////////
+//                 Topology
+///////////////////////////////////////////////////////////
+
+// CPU (hardware thread) location in the topology
+struct cpu_info {
+    int cpu = 0;
+    int core = 0;       // core id (unique in the system)
+    int package = 0;    // physical package (socket)
+    int l3 = 0;         // L3 cache id (first CPU sharing the cache)
+    int node = 0;       // NUMA node
+    int smt_rank = 0;   // index of the CPU among its core siblings
+};
+
+// Distance between two CPUs in the topology
+enum class cpu_distance { same, smt, l3, package, remote };
+
+struct topology {
+    std::vector<cpu_info> cpus;
+};
+
+inline topology topo;
+
+const std::string sysfs_cpu = "/sys/devices/system/cpu/";
+
+// sysfs_read: Read the first line of sysfs file, return false on error
+inline bool sysfs_read(const std::string &fname, std::string &val)
+{
+    std::ifstream file(fname);
+
+    if (!file.good() || !std::getline(file, val))
+        return false;
+
+    return true;
+}
+
+// sysfs_read_int: Read integer from sysfs file (def on error)
+inline int sysfs_read_int(const std::string &fname, int def)
+{
+    std::string str;
+    int val;
+
+    if (!sysfs_read(fname, str) || !parse_int(str, val))
+        return def;
+
+    return val;
+}
+
+// sysfs_read_cpus: Read CPU list from sysfs file (empty on error)
+inline std::vector<int> sysfs_read_cpus(const std::string &fname)
+{
+    std::string str;
+    std::vector<int> cpus;
+
+    if (!sysfs_read(fname, str) || !parse_cpu_list(str, cpus))
+        return {};
+
+    return cpus;
+}
+
+// cpu_node: NUMA node of the CPU (cpuN/nodeM link in sysfs)
+inline int cpu_node(int cpu)
+{
+    auto dir = opendir((sysfs_cpu + "cpu" + std::to_string(cpu)).c_str());
+
+    if (dir == nullptr)
+        return 0;
+
+    auto node = 0;
+
+    while (auto ent = readdir(dir)) {
+        const std::string name = ent->d_name;
+        int id;
+
+        if ((name.compare(0, 4, "node") == 0) &&
+            parse_int(name.substr(4), id)) {
+            node = id;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return node;
+}
+
+// cpu_l3: Id of L3 (or the last level) cache shared by the CPU
+inline int cpu_l3(int cpu)
+{
+    const auto cache_dir = sysfs_cpu + "cpu" + std::to_string(cpu) +
+                           "/cache/";
+    auto l3 = cpu, max_level = 0;
+
+    for (auto index = 0; ; index++) {
+        const auto dir = cache_dir + "index" + std::to_string(index) + "/";
+        const auto level = sysfs_read_int(dir + "level", -1);
+
+        if (level < 0)
+            break;
+
+        const auto shared = sysfs_read_cpus(dir + "shared_cpu_list");
+
+        if ((level >= max_level) && !shared.empty()) {
+            max_level = level;
+            l3 = *std::min_element(shared.begin(), shared.end());
+        }
+    }
+
+    return l3;
+}
+
+// topology_discover: Read CPU topology from sysfs
+//                    (flat topology if sysfs is not available)
+inline void topology_discover()
+{
+    auto online = sysfs_read_cpus(sysfs_cpu + "online");
+
+    if (online.empty()) {
+        for (auto i = 0u; i < std::thread::hardware_concurrency(); i++)
+            online.push_back(i);
+    }
+
+    topo.cpus.clear();
+
+    for (auto cpu: online) {
+        const auto dir = sysfs_cpu + "cpu" + std::to_string(cpu) +
+                         "/topology/";
+        cpu_info info;
+
+        info.cpu = cpu;
+        info.package = sysfs_read_int(dir + "physical_package_id", 0);
+        info.l3 = cpu_l3(cpu);
+        info.node = cpu_node(cpu);
+
+        // Core is identified by its first sibling
+        auto siblings = sysfs_read_cpus(dir + "thread_siblings_list");
+
+        if (siblings.empty())
+            siblings.push_back(cpu);
+
+        info.core = *std::min_element(siblings.begin(), siblings.end());
+        info.smt_rank = std::find(siblings.begin(), siblings.end(), cpu) -
+                        siblings.begin();
+
+        topo.cpus.push_back(info);
+    }
+}
+
+// cpu_online: Check if the CPU is in the topology
+inline bool cpu_online(int cpu)
+{
+    return std::any_of(topo.cpus.begin(), topo.cpus.end(),
+                       [=](const cpu_info &info){return info.cpu == cpu;});
+}
+
+// cpu_find: Topology info of the CPU
+inline const cpu_info &cpu_find(int cpu)
+{
+    for (const auto &info: topo.cpus) {
+        if (info.cpu == cpu)
+            return info;
+    }
+
+    std::cerr << "CPU " << cpu << " is not online" << std::endl;
+    exit(1);
+}
+
+// cpu_dist: Topology distance between two CPUs
+inline cpu_distance cpu_dist(int cpu1, int cpu2)
+{
+    const auto &a = cpu_find(cpu1), &b = cpu_find(cpu2);
+
+    if (a.cpu == b.cpu)
+        return cpu_distance::same;
+    else if (a.core == b.core)
+        return cpu_distance::smt;
+    else if (a.l3 == b.l3)
+        return cpu_distance::l3;
+    else if (a.package == b.package)
+        return cpu_distance::package;
+    else
+        return cpu_distance::remote;
+}
+
+// cpu_dist_name: Name of topology distance
+inline std::string cpu_dist_name(cpu_distance dist)
+{
+    switch (dist) {
+    case cpu_distance::same:    return "same";
+    case cpu_distance::smt:     return "smt";
+    case cpu_distance::l3:      return "l3";
+    case cpu_distance::package: return "package";
+    case cpu_distance::remote:  return "remote";
+    }
+
+    return "";
+}
+
+// topology_print: Print topology summary
+inline void topology_print()
+{
+    auto count = [](auto field) {
+        std::vector<int> ids;
+        for (const auto &info: topo.cpus)
+            ids.push_back(info.*field);
+        std::sort(ids.begin(), ids.end());
+        return std::unique(ids.begin(), ids.end()) - ids.begin();
+    };
+
+    std::cout << "topology: " << count(&cpu_info::package) << " packages, "
+              << count(&cpu_info::node) << " nodes, "
+              << count(&cpu_info::l3) << " L3, "
+              << count(&cpu_info::core) << " cores, "
+              << topo.cpus.size() << " cpus" << std::endl;
+}
+
+///////////////////////////////////////////////////////////
+//                 Placement policies
+///////////////////////////////////////////////////////////
+
+// Policies of thread placement:
+//   none    - thread i on i-th CPU of the list (kernel numbering)
+//   compact - fill SMT siblings, then cores of the same L3, then package
+//   scatter - spread over packages, then L3 caches, then cores,
+//             SMT siblings are used last
+//   smt     - as compact, MESI pair on SMT siblings of one core
+//   l3      - different cores of the same L3 (CCX) first
+//   socket  - alternate packages, MESI pair on different packages
+enum class placement { none, compact, scatter, smt, l3, socket };
+
+// placement_by_name: Parse placement policy name
+inline bool placement_by_name(const std::string &name, placement &policy)
+{
+    const std::map<std::string, placement> policies{
+        {"none", placement::none}, {"compact", placement::compact},
+        {"scatter", placement::scatter}, {"smt", placement::smt},
+        {"l3", placement::l3}, {"socket", placement::socket}};
+
+    auto it = policies.find(name);
+
+    if (it == policies.end())
+        return false;
+
+    policy = it->second;
+    return true;
+}
+
+// placement_name: Name of placement policy
+inline std::string placement_name(placement policy)
+{
+    switch (policy) {
+    case placement::none:    return "none";
+    case placement::compact: return "compact";
+    case placement::scatter: return "scatter";
+    case placement::smt:     return "smt";
+    case placement::l3:      return "l3";
+    case placement::socket:  return "socket";
+    }
+
+    return "";
+}
+
+// placement_cpus: Order of CPUs for threads 0, 1, ... according to policy
+//                 (cpus is the set of allowed CPUs, all if empty)
+inline std::vector<int> placement_cpus(placement policy,
+                                       const std::vector<int> &cpus)
+{
+    std::vector<cpu_info> infos;
+
+    for (const auto &info: topo.cpus) {
+        if (cpus.empty() ||
+            (std::find(cpus.begin(), cpus.end(), info.cpu) != cpus.end()))
+            infos.push_back(info);
+    }
+
+    // Keep order of allowed CPUs for none policy
+    if (policy == placement::none) {
+        if (cpus.empty()) {
+            std::vector<int> res;
+            for (const auto &info: infos)
+                res.push_back(info.cpu);
+            return res;
+        }
+        return cpus;
+    }
+
+    // Ranks of cores within L3, of L3 within package
+    std::map<int, int> core_rank, l3_rank;
+    std::map<std::pair<int, int>, int> nranks;
+
+    for (const auto &info: infos) {
+        if (core_rank.count(info.core) == 0)
+            core_rank[info.core] = nranks[{0, info.l3}]++;
+
+        if (l3_rank.count(info.l3) == 0)
+            l3_rank[info.l3] = nranks[{1, info.package}]++;
+    }
+
+    auto key = [&](const cpu_info &info) {
+        const auto core = core_rank[info.core], l3 = l3_rank[info.l3];
+
+        switch (policy) {
+        case placement::scatter:
+        case placement::socket:
+            return std::make_tuple(info.smt_rank, core, l3, info.package);
+        case placement::l3:
+            return std::make_tuple(info.smt_rank, info.package, l3, core);
+        default:
+            return std::make_tuple(info.package, l3, core, info.smt_rank);
+        }
+    };
+
+    std::stable_sort(infos.begin(), infos.end(),
+                     [&](const cpu_info &a, const cpu_info &b) {
+                         return key(a) < key(b);
+                     });
+
+    std::vector<int> res;
+
+    for (const auto &info: infos)
+        res.push_back(info.cpu);
+
+    return res;
+}
+
+// placement_pair: CPUs of measurement and preparation threads according
+//                 to policy, false if the topology has no such pair
+inline bool placement_pair(placement policy, const std::vector<int> &cpus,
+                           int &meas_cpu, int &prep_cpu)
+{
+    const auto order = placement_cpus(policy, cpus);
+
+    cpu_distance want;
+
+    switch (policy) {
+    case placement::smt:    want = cpu_distance::smt;    break;
+    case placement::l3:     want = cpu_distance::l3;     break;
+    case placement::socket: want = cpu_distance::remote; break;
+    default:
+        if (order.size() < 2)
+            return false;
+        meas_cpu = order[0];
+        prep_cpu = order[1];
+        return true;
+    }
+
+    for (auto i = 0u; i < order.size(); i++) {
+        for (auto j = 0u; j < order.size(); j++) {
+            if (cpu_dist(order[i], order[j]) == want) {
+                meas_cpu = order[i];
+                prep_cpu = order[j];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
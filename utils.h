@@ -10,41 +10,108 @@
 #define _GNU_SOURCE
 #endif
 
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
 #include <thread>
+#include <vector>
+#include <mutex>
 #include <condition_variable>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////
+//                 Optimization barriers
+///////////////////////////////////////////////////////////
+
+// do_not_optimize: Make the compiler assume that val is used, so the 
+//                  computation of val is not discarded at -O2/-O3
+template <typename T>
+inline void do_not_optimize(const T &val)
+{
+    asm volatile("" : : "r,m"(val) : "memory");
+}
 
 ///////////////////////////////////////////////////////////
 //                 Barrier
 ///////////////////////////////////////////////////////////
 
-class barrier
+// cpu_relax: Hint for spin-wait loops
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// cpu_pause: Spin for n pause instructions
+inline void cpu_pause(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+        cpu_relax();
+}
+
+// Types of barriers
+enum class barrier_type { condvar, central, tree, dissem };
+
+// barrier_type_by_name: Parse barrier type name
+inline bool barrier_type_by_name(const std::string &name, barrier_type &type)
+{
+    if (name == "condvar")
+        type = barrier_type::condvar;
+    else if (name == "central")
+        type = barrier_type::central;
+    else if (name == "tree")
+        type = barrier_type::tree;
+    else if (name == "dissem")
+        type = barrier_type::dissem;
+    else
+        return false;
+
+    return true;
+}
+
+// barrier_type_name: Name of barrier type
+inline std::string barrier_type_name(barrier_type type)
+{
+    switch (type) {
+    case barrier_type::condvar: return "condvar";
+    case barrier_type::central: return "central";
+    case barrier_type::tree:    return "tree";
+    case barrier_type::dissem:  return "dissem";
+    }
+
+    return "";
+}
+
+// condvar_barrier: Barrier based on mutex and condition variable
+class condvar_barrier
 {
 public:
-    barrier() {}
+    condvar_barrier() {}
 
-    barrier(int count): thread_count(count) {}
+    condvar_barrier(int count): thread_count(count) {}
 
     void init(int count)
     {
         std::unique_lock<std::mutex> lk(mut);
         thread_count = count;
-        counter = waiting = 0;
+        counter = 0;
     }
 
     void wait()
     {
-        // fence mechanism
         std::unique_lock<std::mutex> lk(mut);
-        ++counter;
-        ++waiting;
-
-        cv.wait(lk, [&]{return counter >= thread_count;});
-        cv.notify_one();
-        --waiting;
+        const auto gen = generation;
 
-        if (waiting == 0) {
-            // reset barrier
+        if (++counter >= thread_count) {
+            // The last thread resets the barrier and releases the others
             counter = 0;
+            ++generation;
+            cv.notify_all();
+        } else {
+            cv.wait(lk, [&]{return gen != generation;});
         }
     }
 
@@ -53,14 +120,281 @@ private:
     std::condition_variable cv;
 
     int counter = 0;
-    int waiting = 0;
     int thread_count = 0;
+    unsigned long generation = 0;
+};
+
+// Thread-local sense of spin barriers (padded to avoid false sharing)
+struct alignas(64) barrier_sense {
+    bool sense = false;
+};
+
+// central_barrier: Centralized sense-reversing spin barrier.
+//                  The last arrived thread resets the counter and
+//                  flips the global sense, the others spin on it
+class central_barrier
+{
+public:
+    void init(int count)
+    {
+        thread_count = count;
+        counter = count;
+        sense = false;
+        local_sense = std::vector<barrier_sense>(count);
+    }
+
+    void wait(int tid)
+    {
+        const bool s = !local_sense[tid].sense;
+        local_sense[tid].sense = s;
+
+        if (counter.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            counter.store(thread_count, std::memory_order_relaxed);
+            sense.store(s, std::memory_order_release);
+        } else {
+            while (sense.load(std::memory_order_acquire) != s)
+                cpu_relax();
+        }
+    }
+
+private:
+    alignas(64) std::atomic<int> counter{0};
+    alignas(64) std::atomic<bool> sense{false};
+    int thread_count = 0;
+    std::vector<barrier_sense> local_sense;
+};
+
+// tree_barrier: Combining tree barrier with per-node sense flags.
+//               Threads arrive at leaves (tree_arity threads per leaf),
+//               the last arrived thread of a node goes to the parent,
+//               and release goes down the tree from the root
+class tree_barrier
+{
+public:
+    static constexpr int tree_arity = 4;
+
+    void init(int count)
+    {
+        // Count nodes on all levels, from leaves to the root
+        std::vector<int> level_size;
+        auto nchildren = count;
+
+        do {
+            nchildren = (nchildren + tree_arity - 1) / tree_arity;
+            level_size.push_back(nchildren);
+        } while (nchildren > 1);
+
+        auto nnodes = 0;
+        for (auto size: level_size)
+            nnodes += size;
+
+        nodes = std::vector<node>(nnodes);
+        local_sense = std::vector<barrier_sense>(count);
+
+        // Link nodes with parents and set the number of children
+        auto first = 0;
+        nchildren = count;
+
+        for (auto size: level_size) {
+            for (auto i = 0; i < size; i++) {
+                auto &n = nodes[first + i];
+                n.nchildren = std::min(tree_arity, 
+                                       nchildren - i * tree_arity);
+                n.counter = n.nchildren;
+                n.sense = false;
+                n.parent = (size > 1) ? &nodes[first + size + i / tree_arity]
+                                      : nullptr;
+            }
+
+            first += size;
+            nchildren = size;
+        }
+    }
+
+    void wait(int tid)
+    {
+        const bool s = !local_sense[tid].sense;
+        local_sense[tid].sense = s;
+
+        arrive(&nodes[tid / tree_arity], s);
+    }
+
+private:
+    struct node {
+        alignas(64) std::atomic<int> counter{0};
+        alignas(64) std::atomic<bool> sense{false};
+        int nchildren = 0;
+        node *parent = nullptr;
+    };
+
+    // arrive: Arrive at the node and wait for release
+    void arrive(node *n, bool s)
+    {
+        if (n->counter.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (n->parent != nullptr)
+                arrive(n->parent, s);
+
+            n->counter.store(n->nchildren, std::memory_order_relaxed);
+            n->sense.store(s, std::memory_order_release);
+        } else {
+            while (n->sense.load(std::memory_order_acquire) != s)
+                cpu_relax();
+        }
+    }
+
+    std::vector<node> nodes;
+    std::vector<barrier_sense> local_sense;
+};
+
+// dissem_barrier: Dissemination barrier. In round r thread i signals 
+//                 thread (i + 2^r) mod n and waits for a signal from
+//                 thread (i - 2^r) mod n
+class dissem_barrier
+{
+public:
+    static constexpr int max_rounds = 16;
+
+    void init(int count)
+    {
+        thread_count = count;
+
+        nrounds = 0;
+        while ((1 << nrounds) < count)
+            nrounds++;
+
+        threads = std::vector<thread_flags>(count);
+    }
+
+    void wait(int tid)
+    {
+        auto &self = threads[tid];
+
+        for (auto r = 0; r < nrounds; r++) {
+            auto &partner = threads[(tid + (1 << r)) % thread_count];
+            partner.flags[self.parity][r].store(self.sense, 
+                                                std::memory_order_release);
+
+            while (self.flags[self.parity][r].load(
+                       std::memory_order_acquire) != self.sense)
+                cpu_relax();
+        }
+
+        if (self.parity == 1)
+            self.sense = !self.sense;
+
+        self.parity = 1 - self.parity;
+    }
+
+private:
+    struct alignas(64) thread_flags {
+        std::atomic<bool> flags[2][max_rounds] = {};
+        int parity = 0;
+        bool sense = true;
+    };
+
+    int thread_count = 0;
+    int nrounds = 0;
+    std::vector<thread_flags> threads;
+};
+
+// barrier: Barrier with selectable implementation
+class barrier
+{
+public:
+    barrier() {}
+
+    void set_type(barrier_type t) { type = t; }
+
+    barrier_type get_type() const { return type; }
+
+    void init(int count)
+    {
+        switch (type) {
+        case barrier_type::condvar: condvar_barr.init(count); break;
+        case barrier_type::central: central_barr.init(count); break;
+        case barrier_type::tree:    tree_barr.init(count);    break;
+        case barrier_type::dissem:  dissem_barr.init(count);  break;
+        }
+    }
+
+    // wait: Wait for all threads (tid is in [0, count))
+    void wait(int tid)
+    {
+        switch (type) {
+        case barrier_type::condvar: condvar_barr.wait();     break;
+        case barrier_type::central: central_barr.wait(tid); break;
+        case barrier_type::tree:    tree_barr.wait(tid);    break;
+        case barrier_type::dissem:  dissem_barr.wait(tid);  break;
+        }
+    }
+
+private:
+    barrier_type type = barrier_type::central;
+
+    condvar_barrier condvar_barr;
+    central_barrier central_barr;
+    tree_barrier tree_barr;
+    dissem_barrier dissem_barr;
 };
 
 ///////////////////////////////////////////////////////////
 //                 Utils
 ///////////////////////////////////////////////////////////
 
+// split: Split string by delimiter
+inline std::vector<std::string> split(const std::string &str, char delim)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(str);
+    std::string item;
+
+    while (std::getline(ss, item, delim)) {
+        if (!item.empty())
+            items.push_back(item);
+    }
+
+    return items;
+}
+
+// parse_int: Parse integer, return false on error
+inline bool parse_int(const std::string &str, int &val)
+{
+    try {
+        std::size_t pos;
+        val = std::stoi(str, &pos);
+        return pos == str.size();
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+// parse_cpu_list: Parse CPU list in sysfs format, e.g. "0-3,8,10-11"
+inline bool parse_cpu_list(const std::string &str, std::vector<int> &list)
+{
+    std::vector<int> res;
+
+    for (const auto &item: split(str, ',')) {
+        const auto range = split(item, '-');
+        int first, last;
+
+        if ((range.size() == 1) && parse_int(range[0], first)) {
+            last = first;
+        } else if ((range.size() != 2) || !parse_int(range[0], first) ||
+                   !parse_int(range[1], last)) {
+            return false;
+        }
+
+        if ((first < 0) || (last < first))
+            return false;
+
+        for (auto cpu = first; cpu <= last; cpu++)
+            res.push_back(cpu);
+    }
+
+    list = res;
+    return true;
+}
+
 // set_affinity: Set affinity for measurement and preparation thread
 //               on different cores
 void set_affinity(std::thread &meas_thr, std::thread &prep_thr,
@@ -108,13 +442,20 @@ void set_affinity(std::thread &meas_thr, int meas_cpu)
 }
 
 // set_affinity_by_tid: Set affinity for measurement thread by thread id
-void set_affinity_by_tid(std::thread &thr, int tid)
+//                      (threads are distributed among cpus round-robin,
+//                      all cores are used if cpus is empty)
+void set_affinity_by_tid(std::thread &thr, int tid,
+                         const std::vector<int> &cpus = {})
 {
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
 
-    const auto ncores = std::thread::hardware_concurrency();
-    CPU_SET(tid % ncores, &cpuset);
+    if (cpus.empty()) {
+        const auto ncores = std::thread::hardware_concurrency();
+        CPU_SET(tid % ncores, &cpuset);
+    } else {
+        CPU_SET(cpus[tid % cpus.size()], &cpuset);
+    }
 
     auto rc = pthread_setaffinity_np(thr.native_handle(),
                                      sizeof(cpu_set_t), &cpuset);